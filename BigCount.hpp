@@ -0,0 +1,208 @@
+#ifndef BIG_COUNT_HPP
+#define BIG_COUNT_HPP
+
+#include <algorithm>
+#include <stdint.h>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Unsigned integer of arbitrary size for solution counts,
+// stored as little-endian 64-bit words without leading zero words.
+class BigCount {
+    std::vector<uint64_t> words_;
+
+    void trim() {
+        while (!words_.empty() && words_.back() == 0) {
+            words_.pop_back();
+        }
+    }
+
+public:
+    BigCount() {
+    }
+
+    BigCount(uint64_t n) {
+        if (n != 0) words_.push_back(n);
+    }
+
+    bool isZero() const {
+        return words_.empty();
+    }
+
+    void swap(BigCount& o) {
+        words_.swap(o.words_);
+    }
+
+    // number of 64-bit words in use
+    size_t size() const {
+        return words_.size();
+    }
+
+    bool operator==(BigCount const& o) const {
+        return words_ == o.words_;
+    }
+
+    bool operator!=(BigCount const& o) const {
+        return words_ != o.words_;
+    }
+
+    bool operator<(BigCount const& o) const {
+        if (words_.size() != o.words_.size()) {
+            return words_.size() < o.words_.size();
+        }
+        for (size_t i = words_.size(); i > 0; --i) {
+            if (words_[i - 1] != o.words_[i - 1]) {
+                return words_[i - 1] < o.words_[i - 1];
+            }
+        }
+        return false;
+    }
+
+    BigCount& operator+=(BigCount const& o) {
+        if (words_.size() < o.words_.size()) {
+            words_.resize(o.words_.size(), 0);
+        }
+        uint64_t carry = 0;
+        for (size_t i = 0; i < words_.size(); ++i) {
+            uint64_t const b = (i < o.words_.size()) ? o.words_[i] : 0;
+            if (b == 0 && carry == 0 && i >= o.words_.size()) break;
+            unsigned __int128 s = static_cast<unsigned __int128>(words_[i])
+                    + b + carry;
+            words_[i] = static_cast<uint64_t>(s);
+            carry = static_cast<uint64_t>(s >> 64);
+        }
+        if (carry != 0) words_.push_back(carry);
+        return *this;
+    }
+
+    // Subtracts o, which must not be greater than this number.
+    BigCount& operator-=(BigCount const& o) {
+        if (*this < o) {
+            throw std::runtime_error("ERROR: BigCount underflow");
+        }
+        uint64_t borrow = 0;
+        for (size_t i = 0; i < words_.size(); ++i) {
+            uint64_t const b = (i < o.words_.size()) ? o.words_[i] : 0;
+            if (b == 0 && borrow == 0 && i >= o.words_.size()) break;
+            uint64_t const a = words_[i];
+            words_[i] = a - b - borrow;
+            borrow = (a < b || (a == b && borrow != 0)) ? 1 : 0;
+        }
+        trim();
+        return *this;
+    }
+
+    BigCount& operator*=(uint64_t n) {
+        if (n == 0) {
+            words_.clear();
+            return *this;
+        }
+        uint64_t carry = 0;
+        for (size_t i = 0; i < words_.size(); ++i) {
+            unsigned __int128 p = static_cast<unsigned __int128>(words_[i]) * n
+                    + carry;
+            words_[i] = static_cast<uint64_t>(p);
+            carry = static_cast<uint64_t>(p >> 64);
+        }
+        if (carry != 0) words_.push_back(carry);
+        return *this;
+    }
+
+    BigCount& operator*=(BigCount const& o) {
+        if (isZero() || o.isZero()) {
+            words_.clear();
+            return *this;
+        }
+        std::vector<uint64_t> r(words_.size() + o.words_.size(), 0);
+        for (size_t i = 0; i < words_.size(); ++i) {
+            uint64_t carry = 0;
+            for (size_t j = 0; j < o.words_.size(); ++j) {
+                unsigned __int128 p =
+                        static_cast<unsigned __int128>(words_[i]) * o.words_[j]
+                        + r[i + j] + carry;
+                r[i + j] = static_cast<uint64_t>(p);
+                carry = static_cast<uint64_t>(p >> 64);
+            }
+            r[i + o.words_.size()] = carry;
+        }
+        words_.swap(r);
+        trim();
+        return *this;
+    }
+
+    // Multiplies by 2^k.
+    BigCount& shiftLeft(int k) {
+        if (isZero() || k <= 0) return *this;
+        size_t const w = k / 64;
+        int const b = k % 64;
+        words_.insert(words_.begin(), w, 0);
+        if (b != 0) {
+            uint64_t carry = 0;
+            for (size_t i = w; i < words_.size(); ++i) {
+                uint64_t const x = words_[i];
+                words_[i] = (x << b) | carry;
+                carry = x >> (64 - b);
+            }
+            if (carry != 0) words_.push_back(carry);
+        }
+        return *this;
+    }
+
+    // Divides by n and returns the remainder.
+    uint32_t divide(uint32_t n) {
+        uint64_t r = 0;
+        for (size_t i = words_.size(); i > 0; --i) {
+            unsigned __int128 x = (static_cast<unsigned __int128>(r) << 64)
+                    | words_[i - 1];
+            words_[i - 1] = static_cast<uint64_t>(x / n);
+            r = static_cast<uint64_t>(x % n);
+        }
+        trim();
+        return static_cast<uint32_t>(r);
+    }
+
+    std::string toString() const {
+        if (isZero()) return "0";
+        BigCount n = *this;
+        std::string s;
+        while (!n.isZero()) {
+            // 19 decimal digits at a time
+            uint64_t r = 0;
+            uint64_t const base = 10000000000000000000ULL;
+            for (size_t i = n.words_.size(); i > 0; --i) {
+                unsigned __int128 x = (static_cast<unsigned __int128>(r) << 64)
+                        | n.words_[i - 1];
+                n.words_[i - 1] = static_cast<uint64_t>(x / base);
+                r = static_cast<uint64_t>(x % base);
+            }
+            n.trim();
+            for (int d = 0; d < 19 && (r != 0 || !n.isZero()); ++d) {
+                s += static_cast<char>('0' + r % 10);
+                r /= 10;
+            }
+        }
+        std::reverse(s.begin(), s.end());
+        return s;
+    }
+
+    // Parses a non-negative decimal number.
+    static BigCount parse(std::string const& s) {
+        BigCount n;
+        for (size_t i = 0; i < s.size(); ++i) {
+            if (s[i] < '0' || '9' < s[i]) {
+                throw std::runtime_error("ERROR: " + s + ": Not a number");
+            }
+            n *= 10;
+            n += BigCount(static_cast<uint64_t>(s[i] - '0'));
+        }
+        return n;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, BigCount const& o) {
+        return os << o.toString();
+    }
+};
+
+#endif // BIG_COUNT_HPP
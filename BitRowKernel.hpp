@@ -0,0 +1,277 @@
+#ifndef BIT_ROW_KERNEL_HPP
+#define BIT_ROW_KERNEL_HPP
+
+#include <stdint.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define BIT_ROW_KERNEL_X86
+#endif
+
+// Kernels on a bit-matrix of "rows" rows stored row by row,
+// each row packed into "rowWords" 64-bit words.
+// They implement the two steps of the frontier reachability update:
+// the Warshall-style "every row that has bit col set gets row src ORed in"
+// and the column clear done when a vertex leaves the frontier.
+// For matrices of one word per row, they also move rows and columns
+// between frontier layouts (depositRows/extractRows).
+// The implementation (AVX2, SSE2 or scalar; BMI2 for the layout moves)
+// is chosen once at runtime from the features of the CPU.
+class BitRowKernel {
+public:
+    typedef uint64_t Word;
+
+    // ORs src (rowWords words) into every row whose bit col is set.
+    // src may be one of the rows of m if its own bit col is not set.
+    static void orIntoRowsHavingBit(Word* m, int rows, int rowWords,
+                                    int col, Word const* src) {
+        impl().orIntoRowsHavingBit(m, rows, rowWords, col, src);
+    }
+
+    // Clears bit col of every row.
+    static void clearColumn(Word* m, int rows, int rowWords, int col) {
+        impl().clearColumn(m, rows, rowWords, col);
+    }
+
+    // Moves row i to row to[i] for i = rows-1,...,0 and spreads its bits
+    // over the set bits of mask (pdep), one word per row.
+    // to[] must be increasing with to[i] >= i.
+    static void depositRows(Word* m, int rows, int const* to, Word mask) {
+        impl().depositRows(m, rows, to, mask);
+    }
+
+    // Moves row i to row to[i] for i = 0,...,rows-1 keeping only the bits
+    // selected by mask, packed to the low end (pext), one word per row.
+    // Rows with to[i] < 0 are dropped; the others satisfy to[i] <= i.
+    static void extractRows(Word* m, int rows, int const* to, Word mask) {
+        impl().extractRows(m, rows, to, mask);
+    }
+
+    // Returns the name of the selected implementation.
+    static char const* name() {
+        return impl().name;
+    }
+
+private:
+    struct Impl {
+        void (*orIntoRowsHavingBit)(Word*, int, int, int, Word const*);
+        void (*clearColumn)(Word*, int, int, int);
+        void (*depositRows)(Word*, int, int const*, Word);
+        void (*extractRows)(Word*, int, int const*, Word);
+        char const* name;
+    };
+
+    static Impl const& impl() {
+        static Impl const selected = select();
+        return selected;
+    }
+
+    static Impl select() {
+        Impl i = {orScalar, clearScalar, depositScalar, extractScalar,
+                  "scalar"};
+#ifdef BIT_ROW_KERNEL_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            i.orIntoRowsHavingBit = orAvx2;
+            i.clearColumn = clearAvx2;
+            i.name = "avx2";
+        }
+        else if (__builtin_cpu_supports("sse2")) {
+            i.orIntoRowsHavingBit = orSse2;
+            i.clearColumn = clearSse2;
+            i.name = "sse2";
+        }
+        if (__builtin_cpu_supports("bmi2")) {
+            i.depositRows = depositBmi2;
+            i.extractRows = extractBmi2;
+        }
+#endif
+        return i;
+    }
+
+    static void orScalar(Word* m, int rows, int rowWords, int col,
+                         Word const* src) {
+        Word const bit = Word(1) << (col & 63);
+        int const cw = col >> 6;
+        for (int i = 0; i < rows; ++i) {
+            Word* r = m + i * rowWords;
+            if ((r[cw] & bit) == 0) continue;
+            for (int k = 0; k < rowWords; ++k) {
+                r[k] |= src[k];
+            }
+        }
+    }
+
+    static void clearScalar(Word* m, int rows, int rowWords, int col) {
+        Word const mask = ~(Word(1) << (col & 63));
+        Word* p = m + (col >> 6);
+        for (int i = 0; i < rows; ++i) {
+            p[i * rowWords] &= mask;
+        }
+    }
+
+    static Word deposit(Word x, Word mask) {
+        Word r = 0;
+        for (Word b = 1; mask != 0; b <<= 1) {
+            Word const low = mask & (~mask + 1);
+            if (x & b) r |= low;
+            mask ^= low;
+        }
+        return r;
+    }
+
+    static Word extract(Word x, Word mask) {
+        Word r = 0;
+        for (Word b = 1; mask != 0; b <<= 1) {
+            Word const low = mask & (~mask + 1);
+            if (x & low) r |= b;
+            mask ^= low;
+        }
+        return r;
+    }
+
+    static void depositScalar(Word* m, int rows, int const* to, Word mask) {
+        for (int i = rows - 1; i >= 0; --i) {
+            m[to[i]] = deposit(m[i], mask);
+        }
+    }
+
+    static void extractScalar(Word* m, int rows, int const* to, Word mask) {
+        for (int i = 0; i < rows; ++i) {
+            if (to[i] >= 0) m[to[i]] = extract(m[i], mask);
+        }
+    }
+
+#ifdef BIT_ROW_KERNEL_X86
+    __attribute__((target("bmi2")))
+    static void depositBmi2(Word* m, int rows, int const* to, Word mask) {
+        for (int i = rows - 1; i >= 0; --i) {
+            m[to[i]] = _pdep_u64(m[i], mask);
+        }
+    }
+
+    __attribute__((target("bmi2")))
+    static void extractBmi2(Word* m, int rows, int const* to, Word mask) {
+        for (int i = 0; i < rows; ++i) {
+            if (to[i] >= 0) m[to[i]] = _pext_u64(m[i], mask);
+        }
+    }
+
+    // With one word per row (frontiers up to 64 vertices) the rows are
+    // processed in parallel, a vector of consecutive rows at a time:
+    // the rows having the bit are selected by a compare mask and
+    // src is blended into them. Wider rows are ORed a vector at a time.
+
+    __attribute__((target("sse2")))
+    static void orSse2(Word* m, int rows, int rowWords, int col,
+                       Word const* src) {
+        Word const bit = Word(1) << (col & 63);
+        int i = 0;
+        if (rowWords == 1) {
+            __m128i const b = _mm_set1_epi64x(static_cast<long long>(bit));
+            __m128i const s = _mm_set1_epi64x(static_cast<long long>(src[0]));
+            for (; i + 2 <= rows; i += 2) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i*>(m + i));
+                // no 64-bit compare in SSE2: the masked word equals bit
+                // iff both of its 32-bit halves do
+                __m128i e = _mm_cmpeq_epi32(_mm_and_si128(v, b), b);
+                e = _mm_and_si128(e, _mm_shuffle_epi32(e, _MM_SHUFFLE(2, 3, 0, 1)));
+                v = _mm_or_si128(v, _mm_and_si128(e, s));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(m + i), v);
+            }
+            for (; i < rows; ++i) {
+                if (m[i] & bit) m[i] |= src[0];
+            }
+            return;
+        }
+        int const cw = col >> 6;
+        for (; i < rows; ++i) {
+            Word* r = m + i * rowWords;
+            if ((r[cw] & bit) == 0) continue;
+            int k = 0;
+            for (; k + 2 <= rowWords; k += 2) {
+                __m128i* q = reinterpret_cast<__m128i*>(r + k);
+                __m128i const s = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + k));
+                _mm_storeu_si128(q, _mm_or_si128(_mm_loadu_si128(q), s));
+            }
+            for (; k < rowWords; ++k) {
+                r[k] |= src[k];
+            }
+        }
+    }
+
+    __attribute__((target("sse2")))
+    static void clearSse2(Word* m, int rows, int rowWords, int col) {
+        if (rowWords != 1) {
+            clearScalar(m, rows, rowWords, col);
+            return;
+        }
+        Word const mask = ~(Word(1) << (col & 63));
+        __m128i const k = _mm_set1_epi64x(static_cast<long long>(mask));
+        int i = 0;
+        for (; i + 2 <= rows; i += 2) {
+            __m128i* q = reinterpret_cast<__m128i*>(m + i);
+            _mm_storeu_si128(q, _mm_and_si128(_mm_loadu_si128(q), k));
+        }
+        for (; i < rows; ++i) {
+            m[i] &= mask;
+        }
+    }
+
+    __attribute__((target("avx2")))
+    static void orAvx2(Word* m, int rows, int rowWords, int col,
+                       Word const* src) {
+        Word const bit = Word(1) << (col & 63);
+        int i = 0;
+        if (rowWords == 1) {
+            __m256i const b = _mm256_set1_epi64x(static_cast<long long>(bit));
+            __m256i const s = _mm256_set1_epi64x(static_cast<long long>(src[0]));
+            for (; i + 4 <= rows; i += 4) {
+                __m256i* q = reinterpret_cast<__m256i*>(m + i);
+                __m256i v = _mm256_loadu_si256(q);
+                __m256i e = _mm256_cmpeq_epi64(_mm256_and_si256(v, b), b);
+                v = _mm256_or_si256(v, _mm256_and_si256(e, s));
+                _mm256_storeu_si256(q, v);
+            }
+            for (; i < rows; ++i) {
+                if (m[i] & bit) m[i] |= src[0];
+            }
+            return;
+        }
+        int const cw = col >> 6;
+        for (; i < rows; ++i) {
+            Word* r = m + i * rowWords;
+            if ((r[cw] & bit) == 0) continue;
+            int k = 0;
+            for (; k + 4 <= rowWords; k += 4) {
+                __m256i* q = reinterpret_cast<__m256i*>(r + k);
+                __m256i const s = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + k));
+                _mm256_storeu_si256(q, _mm256_or_si256(_mm256_loadu_si256(q), s));
+            }
+            for (; k < rowWords; ++k) {
+                r[k] |= src[k];
+            }
+        }
+    }
+
+    __attribute__((target("avx2")))
+    static void clearAvx2(Word* m, int rows, int rowWords, int col) {
+        if (rowWords != 1) {
+            clearScalar(m, rows, rowWords, col);
+            return;
+        }
+        Word const mask = ~(Word(1) << (col & 63));
+        __m256i const k = _mm256_set1_epi64x(static_cast<long long>(mask));
+        int i = 0;
+        for (; i + 4 <= rows; i += 4) {
+            __m256i* q = reinterpret_cast<__m256i*>(m + i);
+            _mm256_storeu_si256(q, _mm256_and_si256(_mm256_loadu_si256(q), k));
+        }
+        for (; i < rows; ++i) {
+            m[i] &= mask;
+        }
+    }
+#endif
+};
+
+#endif // BIT_ROW_KERNEL_HPP
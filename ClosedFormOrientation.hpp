@@ -0,0 +1,244 @@
+#ifndef CLOSED_FORM_ORIENTATION_HPP
+#define CLOSED_FORM_ORIENTATION_HPP
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "BigCount.hpp"
+#include "tdzdd/util/Graph.hpp"
+
+// Counts the acyclic orientations of graphs of a known shape without
+// building a ZDD:
+//   a graph with a self-loop: 0
+//   forest with m edges:      2^m
+//   cycle C_k:                2^k - 2
+//   complete graph K_n:       n!
+//   series-parallel graph:    by series-parallel reduction
+// classify() returns NONE if the graph is none of these.
+class ClosedFormOrientation {
+public:
+    enum Kind { NONE, LOOP, FOREST, CYCLE, COMPLETE, SERIES_PARALLEL };
+
+    static char const* kindName(Kind kind) {
+        switch (kind) {
+        case LOOP:
+            return "self-loop";
+        case FOREST:
+            return "forest";
+        case CYCLE:
+            return "cycle";
+        case COMPLETE:
+            return "complete graph";
+        case SERIES_PARALLEL:
+            return "series-parallel";
+        default:
+            return "none";
+        }
+    }
+
+    static Kind classify(const tdzdd::Graph& graph, BigCount& count) {
+        const int n = graph.vertexSize();
+        const int m = graph.edgeSize();
+
+        std::vector<int> deg(n + 1, 0);
+        for (int e = 0; e < m; ++e) {
+            const tdzdd::Graph::EdgeInfo& edge = graph.edgeInfo(e);
+            if (edge.v1 == edge.v2) {
+                count = BigCount(0);
+                return LOOP;
+            }
+            ++deg[edge.v1];
+            ++deg[edge.v2];
+        }
+
+        const int components = countComponents(graph);
+        if (m == n - components) {
+            count = BigCount(1);
+            count.shiftLeft(m);
+            return FOREST;
+        }
+
+        bool allTwo = true;
+        for (int v = 1; v <= n; ++v) {
+            if (deg[v] != 2) allTwo = false;
+        }
+        if (components == 1 && allTwo) {
+            count = BigCount(1);
+            count.shiftLeft(n);
+            count -= BigCount(2);
+            return CYCLE;
+        }
+
+        if (static_cast<long long>(m) == static_cast<long long>(n) * (n - 1) / 2
+                && isSimple(graph)) {
+            count = BigCount(1);
+            for (int i = 2; i <= n; ++i) {
+                count *= static_cast<uint64_t>(i);
+            }
+            return COMPLETE;
+        }
+
+        if (reduceSeriesParallel(graph, count)) {
+            return SERIES_PARALLEL;
+        }
+        return NONE;
+    }
+
+private:
+    // A two-terminal network N with terminals s and t is described by
+    // c = (-1)^(i+1) Z_c(N) and d = (-1)^i Z_d(N), where i is the number
+    // of inner vertices and Z_c (Z_d) sums q^(k(A)-1) (q^(k(A)-2)) (-1)^|A|
+    // over the edge subsets A connecting (not connecting) s and t, taken
+    // at q = -1. Both are non-negative; a single edge is (1, 1).
+    struct Network {
+        BigCount c;
+        BigCount d;
+    };
+
+    static int countComponents(const tdzdd::Graph& graph) {
+        const int n = graph.vertexSize();
+        std::vector<int> parent(n + 1);
+        for (int v = 0; v <= n; ++v) {
+            parent[v] = v;
+        }
+        int components = n;
+        for (int e = 0; e < graph.edgeSize(); ++e) {
+            const tdzdd::Graph::EdgeInfo& edge = graph.edgeInfo(e);
+            int a = find(parent, edge.v1);
+            int b = find(parent, edge.v2);
+            if (a != b) {
+                parent[a] = b;
+                --components;
+            }
+        }
+        return components;
+    }
+
+    static int find(std::vector<int>& parent, int v) {
+        while (parent[v] != v) {
+            parent[v] = parent[parent[v]];
+            v = parent[v];
+        }
+        return v;
+    }
+
+    static bool isSimple(const tdzdd::Graph& graph) {
+        std::vector<std::unordered_map<int, int> > adj(graph.vertexSize() + 1);
+        for (int e = 0; e < graph.edgeSize(); ++e) {
+            const tdzdd::Graph::EdgeInfo& edge = graph.edgeInfo(e);
+            const int u = std::min(edge.v1, edge.v2);
+            const int w = std::max(edge.v1, edge.v2);
+            if (!adj[u].insert(std::make_pair(w, e)).second) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // N1 and N2 joined at one terminal, which becomes an inner vertex.
+    static Network series(Network const& a, Network const& b) {
+        Network r;
+        r.c = a.c;
+        r.c *= b.c;
+        BigCount t = a.d;
+        t *= b.d;
+        r.d = a.c;
+        r.d *= b.d;
+        r.d += t;
+        t = a.d;
+        t *= b.c;
+        r.d += t;
+        return r;
+    }
+
+    // N1 and N2 joined at both terminals.
+    static Network parallel(Network const& a, Network const& b) {
+        Network r;
+        r.c = a.c;
+        r.c *= b.d;
+        BigCount t = a.d;
+        t *= b.c;
+        r.c += t;
+        t = a.c;
+        t *= b.c;
+        r.c -= t;
+        r.d = a.d;
+        r.d *= b.d;
+        return r;
+    }
+
+    // Repeatedly merges parallel edges, removes vertices of degree at most
+    // one and contracts vertices of degree two into a single edge. The
+    // graph is series-parallel (every block is) iff nothing is left.
+    // A pendant network contributes c + d orientations of its own.
+    static bool reduceSeriesParallel(const tdzdd::Graph& graph,
+                                     BigCount& count) {
+        const int n = graph.vertexSize();
+        // adj[u][w]: index in nets of the network between u and w
+        std::vector<std::unordered_map<int, int> > adj(n + 1);
+        std::vector<Network> nets;
+
+        Network single;
+        single.c = BigCount(1);
+        single.d = BigCount(1);
+        for (int e = 0; e < graph.edgeSize(); ++e) {
+            const tdzdd::Graph::EdgeInfo& edge = graph.edgeInfo(e);
+            join(adj, nets, edge.v1, edge.v2, single);
+        }
+
+        count = BigCount(1);
+        std::vector<int> work;
+        for (int v = 1; v <= n; ++v) {
+            if (adj[v].size() <= 2) work.push_back(v);
+        }
+        while (!work.empty()) {
+            const int u = work.back();
+            work.pop_back();
+            if (adj[u].size() == 1) {
+                const int w = adj[u].begin()->first;
+                const Network& net = nets[adj[u].begin()->second];
+                BigCount f = net.c;
+                f += net.d;
+                count *= f;
+                adj[u].clear();
+                adj[w].erase(u);
+                if (adj[w].size() <= 2) work.push_back(w);
+            } else if (adj[u].size() == 2) {
+                std::unordered_map<int, int>::const_iterator it = adj[u].begin();
+                const int w1 = it->first;
+                const int n1 = it->second;
+                ++it;
+                const int w2 = it->first;
+                const int n2 = it->second;
+                adj[u].clear();
+                adj[w1].erase(u);
+                adj[w2].erase(u);
+                join(adj, nets, w1, w2, series(nets[n1], nets[n2]));
+                if (adj[w1].size() <= 2) work.push_back(w1);
+                if (adj[w2].size() <= 2) work.push_back(w2);
+            }
+        }
+        for (int v = 1; v <= n; ++v) {
+            if (!adj[v].empty()) return false;
+        }
+        return true;
+    }
+
+    // Adds network net between u and w, merging it into the one already
+    // there.
+    static void join(std::vector<std::unordered_map<int, int> >& adj,
+                     std::vector<Network>& nets, int u, int w,
+                     Network const& net) {
+        std::unordered_map<int, int>::iterator it = adj[u].find(w);
+        if (it != adj[u].end()) {
+            nets[it->second] = parallel(nets[it->second], net);
+            return;
+        }
+        adj[u][w] = static_cast<int>(nets.size());
+        adj[w][u] = static_cast<int>(nets.size());
+        nets.push_back(net);
+    }
+};
+
+#endif // CLOSED_FORM_ORIENTATION_HPP
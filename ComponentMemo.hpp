@@ -0,0 +1,191 @@
+#ifndef COMPONENT_MEMO_HPP
+#define COMPONENT_MEMO_HPP
+
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "tdzdd/util/Graph.hpp"
+
+// Canonical form of a multigraph: two graphs get the same form iff they are
+// isomorphic. The form is the sorted edge list of the graph relabeled by
+// the lexicographically smallest labeling among the leaves of an
+// individualization-refinement search. The search has no automorphism
+// pruning, so it gives up (and compute() returns false) once it would
+// visit more than maxLeaves leaves, which only happens on highly symmetric
+// graphs. Graphs of more than maxVertices vertices are not tried at all.
+class CanonicalForm {
+    int n_;
+    // neighbors of each vertex (0-based), one entry per edge
+    std::vector<std::vector<int> > adj_;
+    std::vector<std::pair<int, int> > edges_;
+    size_t leaves_;
+    size_t maxLeaves_;
+    int maxVertices_;
+    std::vector<int> best_;
+
+    // Refines colors until the partition is equitable. New colors are the
+    // ranks of (color, sorted neighbor colors), so they do not depend on
+    // the vertex numbering.
+    void refine(std::vector<int>& color) const {
+        int classes = -1;
+        for (;;) {
+            std::vector<std::pair<std::vector<int>, int> > sig(n_);
+            for (int v = 0; v < n_; ++v) {
+                std::vector<int>& s = sig[v].first;
+                s.reserve(adj_[v].size() + 1);
+                for (size_t i = 0; i < adj_[v].size(); ++i) {
+                    s.push_back(color[adj_[v][i]]);
+                }
+                std::sort(s.begin(), s.end());
+                s.insert(s.begin(), color[v]);
+                sig[v].second = v;
+            }
+            std::sort(sig.begin(), sig.end());
+            int c = 0;
+            for (int i = 0; i < n_; ++i) {
+                if (i > 0 && sig[i].first != sig[i - 1].first) ++c;
+                color[sig[i].second] = c;
+            }
+            if (c + 1 == classes) return;
+            classes = c + 1;
+        }
+    }
+
+    // Returns false if the leaf budget is exceeded.
+    bool search(std::vector<int> const& color) {
+        // the first smallest color shared by several vertices
+        std::vector<int> size(n_, 0);
+        for (int v = 0; v < n_; ++v) {
+            ++size[color[v]];
+        }
+        int target = -1;
+        for (int c = 0; c < n_; ++c) {
+            if (size[c] > 1) {
+                target = c;
+                break;
+            }
+        }
+        if (target < 0) {
+            if (++leaves_ > maxLeaves_) return false;
+            std::vector<int> form;
+            form.reserve(2 * edges_.size() + 1);
+            form.push_back(n_);
+            std::vector<std::pair<int, int> > e(edges_.size());
+            for (size_t i = 0; i < edges_.size(); ++i) {
+                int a = color[edges_[i].first];
+                int b = color[edges_[i].second];
+                e[i] = std::make_pair(std::min(a, b), std::max(a, b));
+            }
+            std::sort(e.begin(), e.end());
+            for (size_t i = 0; i < e.size(); ++i) {
+                form.push_back(e[i].first);
+                form.push_back(e[i].second);
+            }
+            if (best_.empty() || form < best_) best_.swap(form);
+            return true;
+        }
+        for (int v = 0; v < n_; ++v) {
+            if (color[v] != target) continue;
+            // individualize v: it precedes the rest of its cell
+            std::vector<int> c(n_);
+            for (int u = 0; u < n_; ++u) {
+                c[u] = 2 * color[u] + ((u == v || color[u] != target) ? 0 : 1);
+            }
+            refine(c);
+            if (!search(c)) return false;
+        }
+        return true;
+    }
+
+public:
+    explicit CanonicalForm(size_t maxLeaves = 4096, int maxVertices = 64)
+        : n_(0), leaves_(0), maxLeaves_(maxLeaves), maxVertices_(maxVertices) {
+    }
+
+    // Computes the canonical form of graph into form.
+    bool compute(const tdzdd::Graph& graph, std::vector<int>& form) {
+        if (graph.vertexSize() > maxVertices_) return false;
+        n_ = graph.vertexSize();
+        adj_.assign(n_, std::vector<int>());
+        edges_.clear();
+        for (int e = 0; e < graph.edgeSize(); ++e) {
+            const tdzdd::Graph::EdgeInfo& edge = graph.edgeInfo(e);
+            const int a = edge.v1 - 1;
+            const int b = edge.v2 - 1;
+            adj_[a].push_back(b);
+            adj_[b].push_back(a);
+            edges_.push_back(std::make_pair(a, b));
+        }
+        leaves_ = 0;
+        best_.clear();
+
+        std::vector<int> color(n_, 0);
+        refine(color);
+        if (!search(color)) return false;
+        form.swap(best_);
+        return true;
+    }
+};
+
+// Memo table from the canonical form of a component to its result of type
+// T, shared by the worker threads. The first thread asking for a form computes it;
+// other threads asking for the same form meanwhile wait for that result,
+// so every isomorphism class is solved once per run.
+template<typename T>
+class ComponentMemo {
+    std::mutex mutex_;
+    std::map<std::vector<int>, std::shared_future<T> > table_;
+    size_t hits_;
+
+public:
+    ComponentMemo()
+        : hits_(0) {
+    }
+
+    // Returns the result of the class of form, calling solve() to compute
+    // it if this is the first component of the class.
+    T get(const std::vector<int>& form, const std::function<T()>& solve) {
+        std::promise<T> promise;
+        std::shared_future<T> future;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = table_.find(form);
+            if (it != table_.end()) {
+                ++hits_;
+                future = it->second;
+            } else {
+                table_[form] = promise.get_future().share();
+            }
+        }
+        if (future.valid()) {
+            return future.get();
+        }
+        try {
+            T result = solve();
+            promise.set_value(result);
+            return result;
+        } catch (...) {
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+    }
+
+    // number of isomorphism classes seen
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return table_.size();
+    }
+
+    // number of components answered from the table
+    size_t hits() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return hits_;
+    }
+};
+
+#endif // COMPONENT_MEMO_HPP
@@ -0,0 +1,214 @@
+#ifndef COMPONENT_PLANNER_HPP
+#define COMPONENT_PLANNER_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+#include <vector>
+
+#include "BigCount.hpp"
+#include "ClosedFormOrientation.hpp"
+#include "FrontierManager.hpp"
+#include "tdzdd/util/Graph.hpp"
+
+// Chooses how to count the acyclic orientations of a component from the
+// shape of its frontier, before running anything:
+//   closed form   if ClosedFormOrientation recognizes the graph
+//   Tutte         with --tutte, if the partition states surely fit
+//                 ZDD_STATES
+//   ZDD           if the reachability states surely fit ZDD_STATES
+//   count-only    otherwise, or if a count is all that was asked for
+// The number of states after edge i is bounded both by the number of
+// states the vertices remaining on the frontier can be in (labeled posets
+// for DagReachSpec, set partitions for FrontierPartitionSpec) and by
+// 2^(i+1), the number of ways to decide the first i+1 edges. The bound is
+// far above the states actually met on dense frontiers, so it only tells
+// which components are safe to build a diagram of. The others are counted
+// level by level within a budget of states (COUNT_STATES in total, and
+// LEVEL_BYTES of them on one level), which measures the real states as it
+// goes; the caller retries in the order of EdgeOrder if the budget runs
+// out, and approximates by KnuthEstimator on DagReachSpec only if it runs
+// out again and an exact count was not asked for.
+class ComponentPlanner {
+public:
+    enum Engine { CLOSED_FORM, TUTTE, ZDD, COUNT_ONLY, APPROXIMATE };
+
+    // summed states of a component whose diagram is built
+    static constexpr double ZDD_STATES = 134217728.0; // 2^27
+    // budget of a component counted level by level: states in total, and
+    // bytes of the states on one level
+    static const size_t COUNT_STATES = size_t(1) << 26;
+    static const size_t LEVEL_BYTES = size_t(1) << 30;
+    // random walks per approximated component: as many as fit about
+    // SAMPLE_WORK row operations, within [MIN_SAMPLES, MAX_SAMPLES]
+    static constexpr double SAMPLE_WORK = 1e8;
+    static const int MIN_SAMPLES = 100;
+    static const int MAX_SAMPLES = 1000;
+
+    struct Plan {
+        Engine engine;
+        ClosedFormOrientation::Kind kind;
+        // the count, if in closed form
+        BigCount count;
+        int vertices;
+        int edges;
+        // frontier tables, to be shared with the spec that runs (null if
+        // in closed form)
+        FrontierManagerPtr frontier;
+        // maximum frontier size (0 if in closed form)
+        int maxWidth;
+        // bound on the states of the chosen engine, summed over the
+        // levels and on the widest level
+        double states;
+        double peakStates;
+
+        // number of random walks, if approximated; a walk takes a step
+        // per edge and a step works on up to maxWidth rows
+        int samples() const {
+            double const work = double(edges) * std::max(maxWidth, 1);
+            return int(std::max<double>(MIN_SAMPLES,
+                    std::min<double>(MAX_SAMPLES, SAMPLE_WORK / work)));
+        }
+
+        // relative cost, used to schedule the components
+        double cost() const {
+            switch (engine) {
+            case CLOSED_FORM:
+                return edges;
+            case APPROXIMATE:
+                return double(samples()) * edges * std::max(maxWidth, 1);
+            case COUNT_ONLY:
+                return std::min(states, double(COUNT_STATES));
+            default:
+                return states;
+            }
+        }
+    };
+
+    static char const* engineName(Engine engine) {
+        switch (engine) {
+        case CLOSED_FORM:
+            return "closed form";
+        case TUTTE:
+            return "Tutte";
+        case ZDD:
+            return "ZDD";
+        case COUNT_ONLY:
+            return "count-only";
+        default:
+            return "approximate";
+        }
+    }
+
+    // number of labeled posets on n elements (OEIS A001035), or infinity
+    // beyond the table
+    static double posets(int n) {
+        static double const table[] = {
+            1.0, 1.0, 3.0, 19.0, 219.0, 4231.0, 130023.0, 6129859.0,
+            431723379.0, 44511042511.0, 6611065248783.0,
+            1396281677105899.0, 414864951055853499.0,
+            171850728381587059351.0, 98484324257128207032183.0,
+            77567171020440688353049939.0, 83480529785490157813844256579.0,
+            122152541250295322862941281269151.0,
+            241939392597201176602897820148085023.0
+        };
+        int const size = sizeof(table) / sizeof(table[0]);
+        return n < size ? table[n] : HUGE_VAL;
+    }
+
+    // number of partitions of a set of n elements (the Bell number)
+    static double partitions(int n) {
+        // row of the Bell triangle
+        std::vector<double> row(1, 1.0);
+        for (int i = 0; i < n; ++i) {
+            std::vector<double> next(1, row.back());
+            for (size_t j = 0; j < row.size(); ++j) {
+                next.push_back(next.back() + row[j]);
+            }
+            row.swap(next);
+        }
+        return row.front();
+    }
+
+    // Sums the bound on the states after each edge, returning the largest
+    // in peak.
+    static double estimateStates(FrontierManager const& fm, int m,
+                                 bool partitionStates, double& peak) {
+        int const maxWidth = fm.getMaxFrontierSize();
+        std::vector<double> bound(maxWidth + 1);
+        for (int w = 0; w <= maxWidth; ++w) {
+            bound[w] = partitionStates ? partitions(w) : posets(w);
+        }
+        double sum = 0;
+        peak = 0;
+        for (int i = 0; i < m; ++i) {
+            double s = std::min(bound[fm.getRemainingVs(i).size()],
+                                std::ldexp(1.0, i + 1));
+            sum += s;
+            peak = std::max(peak, s);
+        }
+        return sum;
+    }
+
+    static Plan plan(tdzdd::Graph const& graph, bool useTutte,
+                     bool countOnly) {
+        Plan p;
+        p.vertices = graph.vertexSize();
+        p.edges = graph.edgeSize();
+        p.maxWidth = 0;
+        p.states = 0;
+        p.peakStates = 0;
+        p.kind = ClosedFormOrientation::classify(graph, p.count);
+        if (p.kind != ClosedFormOrientation::NONE) {
+            p.engine = CLOSED_FORM;
+            return p;
+        }
+
+        p.frontier = std::make_shared<const FrontierManager>(graph);
+        FrontierManager const& fm = *p.frontier;
+        p.maxWidth = fm.getMaxFrontierSize();
+        if (useTutte) {
+            p.states = estimateStates(fm, p.edges, true, p.peakStates);
+            if (p.states <= ZDD_STATES) {
+                p.engine = TUTTE;
+                return p;
+            }
+            // the same count may still be in reach of the reachability
+            // states, which are fewer on wide sparse frontiers
+        }
+        p.states = estimateStates(fm, p.edges, false, p.peakStates);
+        p.engine = p.states <= ZDD_STATES && !countOnly ? ZDD : COUNT_ONLY;
+        return p;
+    }
+
+    // number of states of stateBytes bytes that fit LEVEL_BYTES, counting
+    // the number kept with each
+    static size_t levelStates(int stateBytes) {
+        return LEVEL_BYTES / (stateBytes + 2 * sizeof(uint64_t));
+    }
+
+    // Prints plan as one line, e.g.
+    //   12 vertices, 20 edges, max frontier 5, <= 1.2e+03 states: ZDD
+    // with exact set if an approximate count would not do.
+    static void print(std::ostream& os, Plan const& p, bool exact) {
+        os << p.vertices << " vertices, " << p.edges << " edges";
+        if (p.engine == CLOSED_FORM) {
+            os << ": closed form ("
+               << ClosedFormOrientation::kindName(p.kind) << ")";
+            return;
+        }
+        std::ios::fmtflags flags = os.flags();
+        std::streamsize precision = os.precision(2);
+        os << ", max frontier " << p.maxWidth << ", <= " << std::scientific
+           << p.states << " states (peak <= " << p.peakStates << "): "
+           << engineName(p.engine);
+        if (p.engine == COUNT_ONLY) {
+            os << " (within " << double(COUNT_STATES) << " states, else "
+               << (exact ? "without a limit" : "approximate") << ")";
+        }
+        os.flags(flags);
+        os.precision(precision);
+    }
+};
+
+#endif // COMPONENT_PLANNER_HPP
@@ -0,0 +1,106 @@
+#ifndef COMPONENT_SCHEDULER_HPP
+#define COMPONENT_SCHEDULER_HPP
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs one job per component on a pool of worker threads.
+// The jobs are dealt largest first by estimated cost, each to the worker
+// with the least cost dealt so far, and every worker runs its own jobs
+// largest first. A worker whose queue runs dry steals the largest job
+// left in the queue with the most remaining cost, so one thread with a
+// few heavy components no longer holds up the others.
+class ComponentScheduler {
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> jobs;
+        // total estimated cost of the jobs in the queue
+        double cost;
+    };
+
+    std::vector<double> costs_;
+    std::vector<Queue> queues_;
+
+    // Takes the next job of worker w, or returns false if none is left.
+    bool pop(size_t w, size_t& job) {
+        {
+            Queue& q = queues_[w];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (!q.jobs.empty()) {
+                job = q.jobs.front();
+                q.jobs.pop_front();
+                q.cost -= costs_[job];
+                return true;
+            }
+        }
+        // Jobs are never added, so retry until every queue is empty.
+        for (;;) {
+            size_t victim = queues_.size();
+            double maxCost = -1;
+            for (size_t v = 0; v < queues_.size(); ++v) {
+                std::lock_guard<std::mutex> lock(queues_[v].mutex);
+                if (!queues_[v].jobs.empty() && queues_[v].cost > maxCost) {
+                    victim = v;
+                    maxCost = queues_[v].cost;
+                }
+            }
+            if (victim == queues_.size()) return false;
+            Queue& q = queues_[victim];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (q.jobs.empty()) continue;
+            job = q.jobs.front();
+            q.jobs.pop_front();
+            q.cost -= costs_[job];
+            return true;
+        }
+    }
+
+public:
+    // costs[i]: estimated cost of job i
+    ComponentScheduler(const std::vector<double>& costs, size_t threads)
+        : costs_(costs),
+          queues_(std::max<size_t>(1, std::min(threads, costs.size())))
+    {
+        std::vector<size_t> order(costs_.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(),
+                         [this](size_t a, size_t b) {
+                             return costs_[a] > costs_[b];
+                         });
+        for (size_t w = 0; w < queues_.size(); ++w) {
+            queues_[w].cost = 0;
+        }
+        for (size_t i = 0; i < order.size(); ++i) {
+            size_t w = 0;
+            for (size_t v = 1; v < queues_.size(); ++v) {
+                if (queues_[v].cost < queues_[w].cost) w = v;
+            }
+            queues_[w].jobs.push_back(order[i]);
+            queues_[w].cost += costs_[order[i]];
+        }
+    }
+
+    // Calls job(i) for every job i and waits for all of them.
+    void run(const std::function<void(size_t)>& job) {
+        std::vector<std::thread> threads;
+        for (size_t w = 0; w < queues_.size(); ++w) {
+            threads.emplace_back([this, w, &job]() {
+                size_t i;
+                while (pop(w, i)) {
+                    job(i);
+                }
+            });
+        }
+        for (size_t w = 0; w < threads.size(); ++w) {
+            threads[w].join();
+        }
+    }
+};
+
+#endif // COMPONENT_SCHEDULER_HPP
@@ -0,0 +1,77 @@
+#ifndef COUNT_PRODUCT_HPP
+#define COUNT_PRODUCT_HPP
+
+#include <ostream>
+#include <stdint.h>
+#include <string>
+
+#include "BigCount.hpp"
+
+// Product of solution counts, such as the counts of the components of a
+// graph. It is kept in 64 bits while it fits and in a BigCount from the
+// first overflow on, so the exact result costs multiword arithmetic only
+// when it is actually large.
+class CountProduct {
+    // the product while it fits in 64 bits
+    uint64_t small_;
+    // whether the product has moved to big_
+    bool isBig_;
+    BigCount big_;
+
+    void promote() {
+        if (isBig_) return;
+        big_ = BigCount(small_);
+        isBig_ = true;
+    }
+
+public:
+    CountProduct()
+        : small_(1), isBig_(false) {
+    }
+
+    void multiply(uint64_t n) {
+        if (!isBig_) {
+            uint64_t r;
+            if (!__builtin_mul_overflow(small_, n, &r)) {
+                small_ = r;
+                return;
+            }
+            promote();
+        }
+        big_ *= n;
+    }
+
+    // Multiplies by a count in decimal, as returned by zddCardinality().
+    void multiply(std::string const& count) {
+        // up to 19 digits always fit in 64 bits
+        if (count.size() <= 19) {
+            multiply(static_cast<uint64_t>(std::stoull(count)));
+        } else {
+            promote();
+            big_ *= BigCount::parse(count);
+        }
+    }
+
+    // Multiplies by 2^k.
+    void multiplyPowerOfTwo(int k) {
+        if (!isBig_) {
+            if (small_ == 0) return;
+            if (k < 64 && small_ <= (UINT64_MAX >> k)) {
+                small_ <<= k;
+                return;
+            }
+            promote();
+        }
+        big_.shiftLeft(k);
+    }
+
+    std::string toString() const {
+        return isBig_ ? big_.toString() : std::to_string(small_);
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, CountProduct const& o) {
+        return os << o.toString();
+    }
+};
+
+#endif // COUNT_PRODUCT_HPP
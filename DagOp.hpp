@@ -2,6 +2,7 @@
 #define DAGOP_HPP
 
 #include "FrontierManager.hpp"
+#include "ThreadArena.hpp"
 #include "tdzdd/DdSpec.hpp"
 #include "tdzdd/util/Graph.hpp"
 #include "unordered_set"
@@ -9,7 +10,13 @@
 
 class FrontierClosure {
 public:
-    std::map<int, std::unordered_set<int> > rel;
+    // allocated from the arena of the thread building the state
+    typedef std::unordered_set<int, std::hash<int>, std::equal_to<int>,
+                               ThreadArenaAllocator<int> > Reach;
+    typedef std::map<int, Reach, std::less<int>,
+                     ThreadArenaAllocator<std::pair<const int, Reach> > > Relation;
+
+    Relation rel;
     bool operator==(const FrontierClosure& other) const {
         return rel == other.rel;
     }
@@ -19,13 +26,14 @@ class DagOpSpec: public tdzdd::DdSpec<DagOpSpec, FrontierClosure, 2> {
     const tdzdd::Graph& graph_;
     const short n_;
     const int m_;
-    const FrontierManager fm_;
+    // fm_ is *fm_ptr_, which may be shared with other specs
+    const FrontierManagerPtr fm_ptr_;
+    const FrontierManager& fm_;
     void initialize(FrontierClosure& data) {
-        data.rel = std::map<int, std::unordered_set<int> >();
-        std::map<int, std::unordered_set<int> >& r = data.rel;
+        data.rel.clear();
     }
     // 在原有的closure上添加边成为新的closure
-    void nextClosure_(std::map<int, std::unordered_set<int> >& r, const int v1, const int v2) {
+    void nextClosure_(FrontierClosure::Relation& r, const int v1, const int v2) {
         r[v1].insert(v1);
         r[v2].insert(v2);
         std::vector<int> to_update;
@@ -40,7 +48,7 @@ class DagOpSpec: public tdzdd::DdSpec<DagOpSpec, FrontierClosure, 2> {
         }
     }
 
-    void erase_(std::map<int, std::unordered_set<int> >& r, const int v1) {
+    void erase_(FrontierClosure::Relation& r, const int v1) {
         std::vector<int> to_update;
         for (const auto& [v, adj] : r) {
             if (adj.find(v1) != adj.end()) {
@@ -55,11 +63,13 @@ class DagOpSpec: public tdzdd::DdSpec<DagOpSpec, FrontierClosure, 2> {
     }
 
 public:
-    explicit DagOpSpec(const tdzdd::Graph& graph)
+    explicit DagOpSpec(const tdzdd::Graph& graph,
+                       FrontierManagerPtr fm = FrontierManagerPtr())
             : graph_(graph),
               n_(static_cast<short>(graph_.vertexSize())),
               m_(graph_.edgeSize()),
-              fm_(graph_){}
+              fm_ptr_(FrontierManager::share(graph_, fm)),
+              fm_(*fm_ptr_){}
     int getRoot(FrontierClosure& data){
         initialize(data);
         return m_;
@@ -68,7 +78,7 @@ public:
         //0-arc represents edge.v1->edge.v2，while 1-arc represents edge.v2->edge.v1
         const int edge_index = m_ - level;
         const tdzdd::Graph::EdgeInfo& edge = graph_.edgeInfo(edge_index);
-        std::map<int, std::unordered_set<int> >& r = data.rel;
+        FrontierClosure::Relation& r = data.rel;
         if (value == 1) { //1-arc
             auto it = r.find(edge.v1);
             if (it != r.end() && it->second.find(edge.v2) != it->second.end()) return 0;
@@ -86,6 +96,23 @@ public:
         }
         return (level == 1) ? -1 : level - 1;
     }
+    // the default hash reads the bytes of the containers, pointers
+    // included, so equal states would never meet
+    size_t hashCode(const FrontierClosure& data) const {
+        size_t h = 0;
+        for (const auto& [v, adj] : data.rel) {
+            // the order of an unordered_set depends on its history
+            size_t a = 0;
+            for (const int w : adj) {
+                a += size_t(w) * 2654435761u;
+            }
+            h += v;
+            h *= 314159257;
+            h += a;
+            h *= 314159257;
+        }
+        return h;
+    }
 };
 
 
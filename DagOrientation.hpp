@@ -5,15 +5,22 @@
 #ifndef DAGORIENTATION_HPP
 #define DAGORIENTATION_HPP
 
+#include "BitRowKernel.hpp"
 #include "FrontierManager.hpp"
+#include "ThreadArena.hpp"
 #include "tdzdd/DdSpec.hpp"
 #include "tdzdd/util/Graph.hpp"
 
-#define SZ 100
+#include <stdint.h>
 
 class FrontierAdjData {
 public:
-    std::vector<std::vector<bool> > adj;//vector is not good
+    // allocated from the arena of the thread building the state
+    typedef std::vector<uint64_t, ThreadArenaAllocator<uint64_t> > Matrix;
+
+    // reachability matrix among the frontier positions, row by row,
+    // each row packed into DagOrientationSpec::rowWords_ words
+    Matrix adj;
     bool operator==(const FrontierAdjData& other) const {
         return adj == other.adj;
     }
@@ -23,46 +30,46 @@ class DagOrientationSpec: public tdzdd::DdSpec<DagOrientationSpec, FrontierAdjDa
     const tdzdd::Graph& graph_;
     const short n_;
     const int m_;
-    const FrontierManager fm_;
+    // fm_ is *fm_ptr_, which may be shared with other specs
+    const FrontierManagerPtr fm_ptr_;
+    const FrontierManager& fm_;
+    // the matrix is getMaxFrontierSize() x getMaxFrontierSize() bits
+    const int size_;
+    const int rowWords_;
+
+    bool get_(const FrontierAdjData::Matrix& r, const int i, const int j) const {
+        return ((r[i * rowWords_ + (j >> 6)] >> (j & 63)) & 1u) != 0;
+    }
+    void set_(FrontierAdjData::Matrix& r, const int i, const int j) const {
+        r[i * rowWords_ + (j >> 6)] |= uint64_t(1) << (j & 63);
+    }
     void initialize(FrontierAdjData& data) {
-        data.adj = std::vector<std::vector<bool> >(SZ, std::vector<bool>(SZ, false));
-        std::vector<std::vector<bool> >& r = data.adj;
-        int n = r.size();
-        for (int i = 0; i < n; i++) {
-            for (int j = 0; j < n; j++) {
-                if (i == j) r[i][j] = true;
-            }
-        }
+        data.adj.assign(size_ * rowWords_, 0);
     }
-    void transClosure_(std::vector<std::vector<bool> >& r, const int v1, const int v2) {
-        int n = r.size();
-        assert(v1 > 0 && v1 < n && v2 > 0 && v2 < n);
-        r[v1][v2] = true;
-        for (int i = 0; i < n; i++) {
-            if (r[i][v1]) {
-                for (int j = 0; j < n; j++) {
-                    if (r[v2][j]) {
-                        r[i][j] = true;
-                    }
-                }
-            }
-        }
+    // v1 and v2 are positions; every row reaching v1 (v1 included, the
+    // diagonal is kept set) gets row v2 ORed in
+    void transClosure_(FrontierAdjData::Matrix& r, const int v1, const int v2) {
+        assert(0 <= v1 && v1 < size_ && 0 <= v2 && v2 < size_);
+        BitRowKernel::orIntoRowsHavingBit(r.data(), size_, rowWords_, v1,
+                                          &r[v2 * rowWords_]);
     }
-    void erase_(std::vector<std::vector<bool> >& r, const int v) {
-        int n = r.size();
-        for (int i = 0; i < n; i++) {
-            for (int j = 0; j < n; j++) {
-                if ((i == v) || (j == v)) r[i][j] = false;
-            }
+    void erase_(FrontierAdjData::Matrix& r, const int v) {
+        BitRowKernel::clearColumn(r.data(), size_, rowWords_, v);
+        for (int k = 0; k < rowWords_; k++) {
+            r[v * rowWords_ + k] = 0;
         }
     }
 
 public:
-    explicit DagOrientationSpec(const tdzdd::Graph& graph)
+    explicit DagOrientationSpec(const tdzdd::Graph& graph,
+                                FrontierManagerPtr fm = FrontierManagerPtr())
     : graph_(graph),
       n_(static_cast<short>(graph_.vertexSize())),
       m_(graph_.edgeSize()),
-      fm_(graph_){}
+      fm_ptr_(FrontierManager::share(graph_, fm)),
+      fm_(*fm_ptr_),
+      size_(fm_.getMaxFrontierSize()),
+      rowWords_((size_ + 63) / 64){}
     int getRoot(FrontierAdjData& data){
         initialize(data);
         return m_;
@@ -71,22 +78,38 @@ public:
         //0-arc represents edge.v1->edge.v2，while 1-arc represents edge.v2->edge.v1
         const int edge_index = m_ - level;
         const tdzdd::Graph::EdgeInfo& edge = graph_.edgeInfo(edge_index);
-        std::vector<std::vector<bool> >& r = data.adj;
+        FrontierAdjData::Matrix& r = data.adj;
+        //entering vertices reach themselves
+        const std::vector<int>& entering_vs = fm_.getEnteringVs(edge_index);
+        for (const int v : entering_vs) {
+            set_(r, fm_.vertexToPos(v), fm_.vertexToPos(v));
+        }
+        const int p1 = fm_.vertexToPos(edge.v1);
+        const int p2 = fm_.vertexToPos(edge.v2);
+        if (p1 == p2) return 0;
         if (value == 1) { //1-arc
-            if (r[edge.v1][edge.v2]) return 0;
-            transClosure_(r, edge.v2, edge.v1);
+            if (get_(r, p1, p2)) return 0;
+            transClosure_(r, p2, p1);
         }
         else {
-            if (r[edge.v2][edge.v1]) return 0;
-            transClosure_(r, edge.v1, edge.v2);
+            if (get_(r, p2, p1)) return 0;
+            transClosure_(r, p1, p2);
         }
         //leaving
         const std::vector<int>& leaving_vs = fm_.getLeavingVs(edge_index);
         for (const int v : leaving_vs) {
-            erase_(r, v);
+            erase_(r, fm_.vertexToPos(v));
         }
         return (level == 1) ? -1 : level - 1;
     }
+    size_t hashCode(const FrontierAdjData& data) const {
+        size_t h = 0;
+        for (size_t i = 0; i < data.adj.size(); ++i) {
+            h += data.adj[i];
+            h *= 314159257;
+        }
+        return h;
+    }
 };
 
 #endif //DAGORIENTATION_HPP
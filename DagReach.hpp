@@ -0,0 +1,266 @@
+#ifndef DAG_REACH_HPP
+#define DAG_REACH_HPP
+
+#include <vector>
+#include <stdint.h>
+
+#include "BitRowKernel.hpp"
+#include "FrontierManager.hpp"
+#include "tdzdd/DdSpec.hpp"
+#include "tdzdd/util/Graph.hpp"
+
+using namespace tdzdd;
+
+// one word of a row of the reachability bit-matrix
+typedef BitRowKernel::Word DagReachWord;
+
+// Frontier-based search for acyclic orientations.
+// The state is the reachability relation among the frontier vertices,
+// stored as a bit-matrix: bit q of row p is set iff the p-th vertex
+// reaches the q-th vertex by the arcs oriented so far, and every vertex
+// reaches itself.
+//
+// The state is kept in a canonical form. Between two edges it holds only
+// the vertices that remain on the frontier (FrontierManager::getRemainingVs),
+// numbered by their rank in that sorted list, so two partial orientations
+// have the same future iff their arrays are equal. The relation is stored
+// closed rather than transitively reduced: both forms are in one-to-one
+// correspondence, and the closed one answers the cycle test with one bit.
+// In getChild the live rows are spread over the ranks of the whole frontier
+// of the edge (getFrontierVs), the arc is added, and the rows of the
+// remaining vertices are packed back. Only the live rows are stored in
+// the nodes of a level (setArraySizeAtLevel), hashed and compared.
+class DagReachSpec
+    : public tdzdd::PodArrayDdSpec<DagReachSpec, DagReachWord, 2> {
+private:
+    // how the matrix is laid out while processing an edge
+    struct Layout {
+        // number of frontier vertices of the edge
+        int width;
+        // number of vertices remaining on the frontier after the edge
+        int live;
+        // ranks of the endpoints v1 and v2 among the frontier vertices
+        int rank1;
+        int rank2;
+        // spread[i]: frontier rank of the i-th remaining vertex of the
+        // previous edge
+        std::vector<int> spread;
+        // frontier ranks of the vertices entering with the edge
+        std::vector<int> entering;
+        // pack[i]: remaining rank of the i-th frontier vertex, or -1 if
+        // it leaves with the edge
+        std::vector<int> pack;
+        // frontier ranks of the previous remaining vertices, and remaining
+        // frontier ranks, as bit masks (used when a row is one word)
+        DagReachWord spreadMask;
+        DagReachWord packMask;
+    };
+
+    // input graph
+    const tdzdd::Graph& graph_;
+    // number of edges
+    const int m_;
+
+    // fm_ is *fm_ptr_, which may be shared with other specs
+    const FrontierManagerPtr fm_ptr_;
+    const FrontierManager& fm_;
+
+    // number of words in a row
+    const int rowWords_;
+
+    std::vector<Layout> layouts_;
+
+    DagReachWord* row(DagReachWord* data, int pos) const {
+        return data + pos * rowWords_;
+    }
+
+    bool getBit(DagReachWord const* data, int p, int q) const {
+        return ((data[p * rowWords_ + (q >> 6)] >> (q & 63)) & 1u) != 0;
+    }
+
+    void setBit(DagReachWord* data, int p, int q) const {
+        row(data, p)[q >> 6] |= DagReachWord(1) << (q & 63);
+    }
+
+    void clearBit(DagReachWord* data, int p, int q) const {
+        row(data, p)[q >> 6] &= ~(DagReachWord(1) << (q & 63));
+    }
+
+    void copyRow(DagReachWord* data, int to, int from) const {
+        for (int k = 0; k < rowWords_; ++k) {
+            row(data, to)[k] = row(data, from)[k];
+        }
+    }
+
+    void clearRow(DagReachWord* data, int pos) const {
+        for (int k = 0; k < rowWords_; ++k) {
+            row(data, pos)[k] = 0;
+        }
+    }
+
+    // the number of live rows of a state at the given level
+    int liveRows(int level) const {
+        return (level >= m_) ? 0 : layouts_[m_ - level - 1].live;
+    }
+
+    // Moves the live rows of the previous edge to their frontier ranks
+    // and adds the entering vertices.
+    void spread(DagReachWord* data, const Layout& l) const {
+        const int n = static_cast<int>(l.spread.size());
+        if (rowWords_ == 1) {
+            BitRowKernel::depositRows(data, n, l.spread.data(), l.spreadMask);
+        }
+        else {
+            // Ranks only grow, so rows and columns are moved from the last.
+            for (int i = n - 1; i >= 0; --i) {
+                const int p = l.spread[i];
+                if (p != i) copyRow(data, p, i);
+                for (int j = n - 1; j >= 0; --j) {
+                    const int q = l.spread[j];
+                    if (q == j || !getBit(data, p, j)) continue;
+                    clearBit(data, p, j);
+                    setBit(data, p, q);
+                }
+            }
+        }
+        for (size_t i = 0; i < l.entering.size(); ++i) {
+            const int p = l.entering[i];
+            clearRow(data, p);
+            setBit(data, p, p);
+        }
+    }
+
+    // Moves the rows of the remaining vertices to their remaining ranks
+    // and drops the leaving ones.
+    void pack(DagReachWord* data, const Layout& l) const {
+        if (rowWords_ == 1) {
+            BitRowKernel::extractRows(data, l.width, l.pack.data(), l.packMask);
+        }
+        else {
+            // Ranks only shrink, so rows and columns are moved from the first.
+            for (int i = 0; i < l.width; ++i) {
+                const int p = l.pack[i];
+                if (p < 0) continue;
+                if (p != i) copyRow(data, p, i);
+                for (int j = 0; j < l.width; ++j) {
+                    const int q = l.pack[j];
+                    if (q == j || !getBit(data, p, j)) continue;
+                    clearBit(data, p, j);
+                    if (q >= 0) setBit(data, p, q);
+                }
+            }
+        }
+        for (int p = l.live; p < l.width; ++p) {
+            clearRow(data, p);
+        }
+    }
+
+    void constructLayouts() {
+        std::vector<int> rank(graph_.vertexSize() + 1, -1);
+        layouts_.resize(m_);
+        for (int e = 0; e < m_; ++e) {
+            Layout& l = layouts_[e];
+            const std::vector<int>& frontier_vs = fm_.getFrontierVs(e);
+            const std::vector<int>& remaining_vs = fm_.getRemainingVs(e);
+            l.width = static_cast<int>(frontier_vs.size());
+            l.live = static_cast<int>(remaining_vs.size());
+            l.spreadMask = 0;
+            l.packMask = 0;
+            for (int i = 0; i < l.width; ++i) {
+                rank[frontier_vs[i]] = i;
+            }
+            const Graph::EdgeInfo& edge = graph_.edgeInfo(e);
+            l.rank1 = rank[edge.v1];
+            l.rank2 = rank[edge.v2];
+            if (e > 0) {
+                const std::vector<int>& prev_vs = fm_.getRemainingVs(e - 1);
+                for (size_t i = 0; i < prev_vs.size(); ++i) {
+                    const int p = rank[prev_vs[i]];
+                    l.spread.push_back(p);
+                    if (p < 64) l.spreadMask |= DagReachWord(1) << p;
+                }
+            }
+            const std::vector<int>& entering_vs = fm_.getEnteringVs(e);
+            for (size_t i = 0; i < entering_vs.size(); ++i) {
+                l.entering.push_back(rank[entering_vs[i]]);
+            }
+            assert(l.spread.size() + l.entering.size() == frontier_vs.size());
+            l.pack.assign(l.width, -1);
+            for (int i = 0; i < l.live; ++i) {
+                const int p = rank[remaining_vs[i]];
+                l.pack[p] = i;
+                if (p < 64) l.packMask |= DagReachWord(1) << p;
+            }
+        }
+    }
+
+    void initialize(DagReachWord* data) const {
+        for (int i = 0; i < getArraySize(); ++i) {
+            data[i] = 0;
+        }
+    }
+
+public:
+    explicit DagReachSpec(const tdzdd::Graph& graph,
+                          FrontierManagerPtr fm = FrontierManagerPtr())
+        : graph_(graph),
+          m_(graph_.edgeSize()),
+          fm_ptr_(FrontierManager::share(graph_, fm)),
+          fm_(*fm_ptr_),
+          rowWords_((fm_.getMaxFrontierSize() + 63) / 64)
+    {
+        constructLayouts();
+        setArraySize(fm_.getMaxFrontierSize() * rowWords_);
+        std::vector<int> sizes(m_ + 1);
+        for (int level = 0; level <= m_; ++level) {
+            sizes[level] = liveRows(level) * rowWords_;
+        }
+        setArraySizeAtLevel(sizes);
+    }
+
+    int getRoot(DagReachWord* data) const {
+        initialize(data);
+        // the empty graph has exactly one (empty) orientation
+        return (m_ == 0) ? -1 : m_;
+    }
+
+    int getChild(DagReachWord* data, int level, int value) const {
+        assert(1 <= level && level <= m_);
+
+        // edge index (starting from 0)
+        const int edge_index = m_ - level;
+        const Layout& l = layouts_[edge_index];
+
+        spread(data, l);
+
+        // 0-arc represents edge.v1->edge.v2, while 1-arc represents
+        // edge.v2->edge.v1
+        const int from = (value == 0) ? l.rank1 : l.rank2;
+        const int to = (value == 0) ? l.rank2 : l.rank1;
+
+        // a self-loop, or "to" already reaches "from": a cycle is closed
+        if (from == to || getBit(data, to, from)) {
+            return 0;
+        }
+        // every vertex reaching "from" now reaches everything "to" reaches;
+        // row "to" itself is unchanged since "to" does not reach "from"
+        BitRowKernel::orIntoRowsHavingBit(data, l.width, rowWords_, from,
+                                          row(data, to));
+
+        pack(data, l);
+        return (level == 1) ? -1 : level - 1;
+    }
+
+    void printState(std::ostream& os, DagReachWord const* data) const {
+        os << "[";
+        for (int p = 0; p < fm_.getMaxFrontierSize(); ++p) {
+            if (p > 0) os << ",";
+            for (int k = rowWords_ - 1; k >= 0; --k) {
+                os << std::hex << data[p * rowWords_ + k] << std::dec;
+            }
+        }
+        os << "]";
+    }
+};
+
+#endif // DAG_REACH_HPP
@@ -0,0 +1,387 @@
+#ifndef EDGE_ORDER_HPP
+#define EDGE_ORDER_HPP
+
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "tdzdd/util/Graph.hpp"
+
+// Chooses the order in which a frontier-based search processes the edges
+// of a graph. The number of states grows exponentially with the frontier
+// size, so several heuristic orders are tried and the one with the
+// smallest maximum frontier (then the smallest sum of frontier sizes over
+// all levels) is kept:
+//   input   the order of the input graph
+//   bfs     vertices in breadth-first order from a peripheral vertex
+//   rcm     reverse Cuthill-McKee
+//   greedy  repeatedly finishes the frontier vertex that brings in the
+//           fewest new vertices
+//   beam    the greedy step with the best few choices kept at each step
+//           (only on graphs small enough for it)
+// The frontier of level i is defined as in FrontierManager: the vertices
+// touched by an edge up to e_i and by an edge from e_i on.
+class EdgeOrder {
+public:
+    struct Result {
+        // name of the heuristic
+        std::string name;
+        // order[i]: the edge processed at level i
+        std::vector<int> order;
+        int maxWidth;
+        long long sumWidth;
+
+        bool operator<(Result const& o) const {
+            if (maxWidth != o.maxWidth) return maxWidth < o.maxWidth;
+            return sumWidth < o.sumWidth;
+        }
+    };
+
+private:
+    // State of processing the edges by finishing one vertex at a time.
+    class Sweep {
+        tdzdd::Graph const* graph_;
+        // unprocessed edges at each vertex
+        std::vector<int> rem_;
+        // neighbors of each vertex not touched yet
+        std::vector<int> fresh_;
+        std::vector<char> touched_;
+        std::vector<char> done_;
+        // where_[v]: position of v in frontier_, or -1
+        std::vector<int> where_;
+        std::vector<int> frontier_;
+
+        void touch(int v) {
+            if (touched_[v]) return;
+            touched_[v] = 1;
+            where_[v] = frontier_.size();
+            frontier_.push_back(v);
+            tdzdd::Graph::NeighborSpan nb = graph_->neighbors(v);
+            for (size_t i = 0; i < nb.size(); ++i) {
+                --fresh_[nb[i]];
+            }
+        }
+
+        void leave(int v) {
+            int const last = frontier_.back();
+            frontier_[where_[v]] = last;
+            where_[last] = where_[v];
+            frontier_.pop_back();
+            where_[v] = -1;
+        }
+
+        void emit(int a) {
+            tdzdd::Graph::EdgeInfo const& e = graph_->edgeInfo(a);
+            done_[a] = 1;
+            order.push_back(a);
+            touch(e.v1);
+            touch(e.v2);
+            const int w = frontier_.size();
+            maxWidth = std::max(maxWidth, w);
+            sumWidth += w;
+            if (--rem_[e.v1] == 0) leave(e.v1);
+            if (e.v2 != e.v1 && --rem_[e.v2] == 0) leave(e.v2);
+        }
+
+    public:
+        std::vector<int> order;
+        int maxWidth;
+        long long sumWidth;
+
+        explicit Sweep(tdzdd::Graph const& graph)
+            : graph_(&graph), rem_(graph.vertexSize() + 1, 0),
+              fresh_(graph.vertexSize() + 1, 0),
+              touched_(graph.vertexSize() + 1, 0),
+              done_(graph.edgeSize(), 0),
+              where_(graph.vertexSize() + 1, -1),
+              maxWidth(0), sumWidth(0) {
+            for (int v = 1; v <= graph.vertexSize(); ++v) {
+                rem_[v] = fresh_[v] = graph.neighbors(v).size();
+            }
+            order.reserve(graph.edgeSize());
+        }
+
+        bool finished() const {
+            return order.size() == done_.size();
+        }
+
+        int frontierSize() const {
+            return frontier_.size();
+        }
+
+        // Returns the frontier vertices, best first: fewest new vertices,
+        // then fewest remaining edges. Returns an untouched vertex of
+        // least degree to start a new component if the frontier is empty.
+        std::vector<int> candidates(size_t k) const {
+            std::vector<int> c;
+            if (frontier_.empty()) {
+                int best = 0;
+                for (int v = 1; v <= graph_->vertexSize(); ++v) {
+                    if (rem_[v] > 0 && (best == 0 || rem_[v] < rem_[best])) {
+                        best = v;
+                    }
+                }
+                if (best != 0) c.push_back(best);
+                return c;
+            }
+            c = frontier_;
+            k = std::min(k, c.size());
+            std::partial_sort(c.begin(), c.begin() + k, c.end(),
+                              [this](int a, int b) {
+                                  if (fresh_[a] != fresh_[b]) {
+                                      return fresh_[a] < fresh_[b];
+                                  }
+                                  if (rem_[a] != rem_[b]) {
+                                      return rem_[a] < rem_[b];
+                                  }
+                                  return a < b;
+                              });
+            c.resize(k);
+            return c;
+        }
+
+        // Processes the remaining edges of v, those to touched vertices
+        // first, so that v and its neighbors leave as early as possible.
+        void finish(int v) {
+            tdzdd::Graph::NeighborSpan nb = graph_->neighbors(v);
+            std::vector<int> near, far;
+            for (size_t i = 0; i < nb.size(); ++i) {
+                if (done_[nb.edge(i)]) continue;
+                (touched_[nb[i]] ? near : far).push_back(nb.edge(i));
+            }
+            for (size_t i = 0; i < near.size(); ++i) {
+                emit(near[i]);
+            }
+            for (size_t i = 0; i < far.size(); ++i) {
+                emit(far[i]);
+            }
+        }
+
+        bool operator<(Sweep const& o) const {
+            if (maxWidth != o.maxWidth) return maxWidth < o.maxWidth;
+            if (frontierSize() != o.frontierSize()) {
+                return frontierSize() < o.frontierSize();
+            }
+            return sumWidth < o.sumWidth;
+        }
+    };
+
+    static Result result(std::string const& name, Sweep const& s) {
+        Result r;
+        r.name = name;
+        r.order = s.order;
+        r.maxWidth = s.maxWidth;
+        r.sumWidth = s.sumWidth;
+        return r;
+    }
+
+    // Returns a vertex far from v in its component: the last vertex of a
+    // breadth-first search, repeated while the distance grows.
+    static int peripheral(tdzdd::Graph const& graph, int v,
+                          std::vector<int>& dist) {
+        int best = -1;
+        for (int round = 0; round < 4; ++round) {
+            std::vector<int> touched;
+            std::deque<int> queue;
+            dist[v] = 0;
+            queue.push_back(v);
+            touched.push_back(v);
+            int last = v;
+            while (!queue.empty()) {
+                int u = queue.front();
+                queue.pop_front();
+                last = u;
+                tdzdd::Graph::NeighborSpan nb = graph.neighbors(u);
+                for (size_t i = 0; i < nb.size(); ++i) {
+                    if (dist[nb[i]] >= 0) continue;
+                    dist[nb[i]] = dist[u] + 1;
+                    queue.push_back(nb[i]);
+                    touched.push_back(nb[i]);
+                }
+            }
+            int const d = dist[last];
+            for (size_t i = 0; i < touched.size(); ++i) {
+                dist[touched[i]] = -1;
+            }
+            if (d <= best) break;
+            best = d;
+            v = last;
+        }
+        return v;
+    }
+
+    // Breadth-first vertex order of every component, neighbors by
+    // increasing degree if byDegree (Cuthill-McKee).
+    static std::vector<int> breadthFirst(tdzdd::Graph const& graph,
+                                         bool byDegree) {
+        const int n = graph.vertexSize();
+        std::vector<int> dist(n + 1, -1);
+        std::vector<char> seen(n + 1, 0);
+        std::vector<int> vs;
+        vs.reserve(n);
+        for (int s = 1; s <= n; ++s) {
+            if (seen[s]) continue;
+            int const root = peripheral(graph, s, dist);
+            size_t head = vs.size();
+            seen[root] = 1;
+            vs.push_back(root);
+            while (head < vs.size()) {
+                int u = vs[head++];
+                tdzdd::Graph::NeighborSpan nb = graph.neighbors(u);
+                size_t const first = vs.size();
+                for (size_t i = 0; i < nb.size(); ++i) {
+                    if (seen[nb[i]]) continue;
+                    seen[nb[i]] = 1;
+                    vs.push_back(nb[i]);
+                }
+                if (byDegree) {
+                    std::stable_sort(vs.begin() + first, vs.end(),
+                                     [&graph](int a, int b) {
+                                         return graph.neighbors(a).size()
+                                                 < graph.neighbors(b).size();
+                                     });
+                }
+            }
+        }
+        return vs;
+    }
+
+    // Processes the vertices in the order vs, each with its edges to the
+    // vertices before it, nearest first.
+    static Result byVertexOrder(tdzdd::Graph const& graph,
+                                std::string const& name,
+                                std::vector<int> const& vs) {
+        std::vector<int> pos(graph.vertexSize() + 1);
+        for (size_t i = 0; i < vs.size(); ++i) {
+            pos[vs[i]] = i;
+        }
+        std::vector<int> order;
+        order.reserve(graph.edgeSize());
+        std::vector<std::pair<int,int> > back;
+        for (size_t i = 0; i < vs.size(); ++i) {
+            tdzdd::Graph::NeighborSpan nb = graph.neighbors(vs[i]);
+            back.clear();
+            for (size_t j = 0; j < nb.size(); ++j) {
+                if (pos[nb[j]] <= int(i)) {
+                    back.push_back(std::make_pair(-pos[nb[j]], nb.edge(j)));
+                }
+            }
+            std::sort(back.begin(), back.end());
+            for (size_t j = 0; j < back.size(); ++j) {
+                order.push_back(back[j].second);
+            }
+        }
+        return measure(graph, name, order);
+    }
+
+public:
+    // Computes the maximum and summed frontier size of order.
+    static Result measure(tdzdd::Graph const& graph, std::string const& name,
+                          std::vector<int> const& order) {
+        const int n = graph.vertexSize();
+        const int m = order.size();
+        std::vector<int> first(n + 1, -1), last(n + 1, -1);
+        for (int i = 0; i < m; ++i) {
+            tdzdd::Graph::EdgeInfo const& e = graph.edgeInfo(order[i]);
+            if (first[e.v1] < 0) first[e.v1] = i;
+            if (first[e.v2] < 0) first[e.v2] = i;
+            last[e.v1] = last[e.v2] = i;
+        }
+        std::vector<int> diff(m + 1, 0);
+        for (int v = 1; v <= n; ++v) {
+            if (first[v] < 0) continue;
+            ++diff[first[v]];
+            --diff[last[v] + 1];
+        }
+        Result r;
+        r.name = name;
+        r.order = order;
+        r.maxWidth = 0;
+        r.sumWidth = 0;
+        int w = 0;
+        for (int i = 0; i < m; ++i) {
+            w += diff[i];
+            r.maxWidth = std::max(r.maxWidth, w);
+            r.sumWidth += w;
+        }
+        return r;
+    }
+
+    static Result input(tdzdd::Graph const& graph) {
+        std::vector<int> order(graph.edgeSize());
+        for (int a = 0; a < graph.edgeSize(); ++a) {
+            order[a] = a;
+        }
+        return measure(graph, "input", order);
+    }
+
+    static Result bfs(tdzdd::Graph const& graph) {
+        return byVertexOrder(graph, "bfs", breadthFirst(graph, false));
+    }
+
+    static Result reverseCuthillMcKee(tdzdd::Graph const& graph) {
+        std::vector<int> vs = breadthFirst(graph, true);
+        std::reverse(vs.begin(), vs.end());
+        return byVertexOrder(graph, "rcm", vs);
+    }
+
+    static Result greedy(tdzdd::Graph const& graph) {
+        Sweep s(graph);
+        while (!s.finished()) {
+            s.finish(s.candidates(1)[0]);
+        }
+        return result("greedy", s);
+    }
+
+    // Keeps the width best sweeps, each extended by its width best
+    // candidates, at every step.
+    static Result beam(tdzdd::Graph const& graph, size_t width) {
+        std::vector<Sweep> states(1, Sweep(graph));
+        for (;;) {
+            std::vector<Sweep> next;
+            bool finished = true;
+            for (size_t i = 0; i < states.size(); ++i) {
+                if (states[i].finished()) {
+                    next.push_back(states[i]);
+                    continue;
+                }
+                finished = false;
+                std::vector<int> c = states[i].candidates(width);
+                for (size_t j = 0; j < c.size(); ++j) {
+                    next.push_back(states[i]);
+                    next.back().finish(c[j]);
+                }
+            }
+            if (finished) break;
+            size_t const keep = std::min(width, next.size());
+            std::partial_sort(next.begin(), next.begin() + keep, next.end());
+            next.erase(next.begin() + keep, next.end());
+            states.swap(next);
+        }
+        return result("beam",
+                      *std::min_element(states.begin(), states.end()));
+    }
+
+    // Tries every heuristic and returns the best order. The beam search
+    // copies its whole state for each of width^2 extensions per vertex,
+    // so it is only run while that stays below a fixed budget.
+    static Result best(tdzdd::Graph const& graph, size_t beamWidth = 4) {
+        Result r = input(graph);
+        Result c = bfs(graph);
+        if (c < r) r = c;
+        c = reverseCuthillMcKee(graph);
+        if (c < r) r = c;
+        c = greedy(graph);
+        if (c < r) r = c;
+        double const cost = double(graph.vertexSize()) * beamWidth * beamWidth
+                * (graph.vertexSize() + graph.edgeSize());
+        if (beamWidth > 1 && cost <= 2e8) {
+            c = beam(graph, beamWidth);
+            if (c < r) r = c;
+        }
+        return r;
+    }
+};
+
+#endif // EDGE_ORDER_HPP
@@ -1,66 +1,93 @@
 #ifndef EULER_ORIENTATION_HPP
 #define FRONTIER_ST_PATH_HPP
 
+#include <algorithm>
+#include <vector>
+
+#include "FrontierBitLayout.hpp"
 #include "FrontierManager.hpp"
 #include "tdzdd/DdSpec.hpp"
 #include "tdzdd/util/Graph.hpp"
 
-class FrontierDegData {
-public:
-    short inDeg;
-    short outDeg;
-};
+class EulerOrientationSpec: public tdzdd::PodArrayDdSpec<EulerOrientationSpec, FrontierBitLayout<2>::Word, 2> {
+    typedef FrontierBitLayout<2>::Word Word;
+    enum { IN_DEG, OUT_DEG };
 
-class EulerOrientationSpec: public tdzdd::PodArrayDdSpec<EulerOrientationSpec, FrontierDegData, 2> {
     const tdzdd::Graph& graph_;
     const short n_;
     const int m_;
-    const FrontierManager fm_;
+    // fm_ is *fm_ptr_, which may be shared with other specs
+    const FrontierManagerPtr fm_ptr_;
+    const FrontierManager& fm_;
+    // inDeg and outDeg of each position, in as many bits as the maximum
+    // degree needs
+    const FrontierBitLayout<2> layout_;
+
+    static int maxDegree(const tdzdd::Graph& graph) {
+        std::vector<int> deg(graph.vertexSize() + 1, 0);
+        for (int a = 0; a < graph.edgeSize(); ++a) {
+            ++deg[graph.edgeInfo(a).v1];
+            ++deg[graph.edgeInfo(a).v2];
+        }
+        return *std::max_element(deg.begin(), deg.end());
+    }
 
-    short getInDeg(const FrontierDegData* data, short v) const {
-        return data[fm_.vertexToPos(v)].inDeg;
+    short getInDeg(const Word* data, short v) const {
+        return layout_.get(data, fm_.vertexToPos(v), IN_DEG);
     }
 
-    short getOutDeg(const FrontierDegData* data, short v) const {
-        return data[fm_.vertexToPos(v)].outDeg;
+    short getOutDeg(const Word* data, short v) const {
+        return layout_.get(data, fm_.vertexToPos(v), OUT_DEG);
     }
 
-    void setInDeg(FrontierDegData* data, short v, short d) const {
-        data[fm_.vertexToPos(v)].inDeg = d;
+    void setInDeg(Word* data, short v, short d) const {
+        layout_.set(data, fm_.vertexToPos(v), IN_DEG, d);
     }
 
-    void setOutDeg(FrontierDegData* data, short v, short d) const {
-        data[fm_.vertexToPos(v)].outDeg = d;
+    void setOutDeg(Word* data, short v, short d) const {
+        layout_.set(data, fm_.vertexToPos(v), OUT_DEG, d);
     }
 
-    void initialize(FrontierDegData* data) const {
-        for (int i = 0; i < fm_.getMaxFrontierSize(); ++i) {
-            data[i].inDeg = 0;
-            data[i].outDeg = 0;
-        }
+    void initialize(Word* data) const {
+        layout_.clearFrom(data, 0, fm_.getMaxFrontierSize());
     }
 public:
-    explicit EulerOrientationSpec(const tdzdd::Graph& graph)
+    explicit EulerOrientationSpec(const tdzdd::Graph& graph,
+                                  FrontierManagerPtr fm = FrontierManagerPtr())
     : graph_(graph),
       n_(static_cast<short>(graph_.vertexSize())),
       m_(graph_.edgeSize()),
-      fm_(graph_)
+      fm_ptr_(FrontierManager::share(graph_, fm)),
+      fm_(*fm_ptr_),
+      layout_({FrontierBitLayout<2>::bitsFor(maxDegree(graph_)),
+               FrontierBitLayout<2>::bitsFor(maxDegree(graph_))})
     {
         if (graph_.vertexSize() > SHRT_MAX) { // SHRT_MAX == 32767
             std::cerr << "The number of vertices should be at most "
                       << SHRT_MAX << std::endl;
             exit(1);
         }
-        setArraySize(fm_.getMaxFrontierSize());
+        setArraySize(layout_.words(fm_.getMaxFrontierSize()));
+        // a state at a level holds the degrees of the positions in use
+        // before its edge
+        std::vector<int> sizes(m_ + 1, 0);
+        for (int level = 1; level < m_; ++level) {
+            sizes[level] = layout_.words(fm_.getPositionBound(m_ - level - 1));
+        }
+        setArraySizeAtLevel(sizes);
     }
-    int getRoot(FrontierDegData* data) {
+    int getRoot(Word* data) {
         initialize(data);
         return m_;
     }
-    int getChild(FrontierDegData* data, int level, int value) {
+    int getChild(Word* data, int level, int value) {
         //0-arc represents edge.v1->edge.v2，while 1-arc represents edge.v2->edge.v1
         const int edge_index = m_ - level;
         const Graph::EdgeInfo& edge = graph_.edgeInfo(edge_index);
+        //clear the positions not in use before this edge
+        layout_.clearFrom(data, (edge_index > 0) ?
+                          fm_.getPositionBound(edge_index - 1) : 0,
+                          fm_.getMaxFrontierSize());
         //check newly entered vs
         const std::vector<int>& entering_vs = fm_.getEnteringVs(edge_index);
         for (const int v : entering_vs) {
@@ -82,6 +109,7 @@ public:
             if (getInDeg(data, v) != getOutDeg(data, v)) {
                 return 0;
             }
+            layout_.clear(data, fm_.vertexToPos(v));
         }
         return (level == 1) ? -1 : level - 1;
     }
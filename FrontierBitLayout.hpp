@@ -0,0 +1,114 @@
+#ifndef FRONTIER_BIT_LAYOUT_HPP
+#define FRONTIER_BIT_LAYOUT_HPP
+
+#include <cassert>
+#include <initializer_list>
+#include <stdint.h>
+
+// Layout of a frontier state as FIELDS unsigned bit fields per position,
+// packed into 64-bit words, for specs whose per-vertex values are small
+// (a degree of at most 2, a component label below the frontier size).
+// The number of fields is fixed at compile time; their widths depend on
+// the graph and are given at construction.
+// A position takes a slot of the summed widths rounded up to a power of
+// two, so that slots never straddle words and finding a field is a shift
+// and a mask of one word.
+template<int FIELDS>
+class FrontierBitLayout {
+public:
+    typedef uint64_t Word;
+
+private:
+    // field f is bits [shift_[f], shift_[f] + width) of a slot
+    int shift_[FIELDS];
+    Word mask_[FIELDS];
+    // log2 of the bits of a slot and of the slots of a word
+    int logSlotBits_;
+    int logSlotsPerWord_;
+
+    Word* word(Word* data, int pos) const {
+        return data + (pos >> logSlotsPerWord_);
+    }
+
+    Word const* word(Word const* data, int pos) const {
+        return data + (pos >> logSlotsPerWord_);
+    }
+
+    int slotShift(int pos) const {
+        return (pos & ((1 << logSlotsPerWord_) - 1)) << logSlotBits_;
+    }
+
+public:
+    // widths lists the number of bits of each field; they sum to at most
+    // 64.
+    FrontierBitLayout(std::initializer_list<int> widths) {
+        assert(widths.size() == FIELDS);
+        int bits = 0;
+        int f = 0;
+        for (int width : widths) {
+            assert(0 < width);
+            shift_[f] = bits;
+            mask_[f] = (width < 64) ? (Word(1) << width) - 1 : ~Word(0);
+            bits += width;
+            ++f;
+        }
+        assert(bits <= 64);
+        logSlotBits_ = 0;
+        while ((1 << logSlotBits_) < bits) {
+            ++logSlotBits_;
+        }
+        logSlotsPerWord_ = 6 - logSlotBits_;
+    }
+
+    // number of bits needed to hold the values 0, ..., maxValue
+    static int bitsFor(int maxValue) {
+        int bits = 1;
+        while (bits < 31 && (1 << bits) <= maxValue) {
+            ++bits;
+        }
+        return bits;
+    }
+
+    // number of words holding the first positions slots
+    int words(int positions) const {
+        return (positions + (1 << logSlotsPerWord_) - 1) >> logSlotsPerWord_;
+    }
+
+    int get(Word const* data, int pos, int field) const {
+        return static_cast<int>((*word(data, pos) >> (slotShift(pos)
+                                 + shift_[field])) & mask_[field]);
+    }
+
+    void set(Word* data, int pos, int field, int value) const {
+        assert(0 <= value && Word(value) <= mask_[field]);
+        int const s = slotShift(pos) + shift_[field];
+        Word* w = word(data, pos);
+        *w = (*w & ~(mask_[field] << s)) | (Word(value) << s);
+    }
+
+    // Sets all the fields of pos to 0.
+    void clear(Word* data, int pos) const {
+        int const s = slotShift(pos);
+        Word const slot = (logSlotBits_ < 6) ?
+                (Word(1) << (1 << logSlotBits_)) - 1 : ~Word(0);
+        *word(data, pos) &= ~(slot << s);
+    }
+
+    // Sets all the fields of the positions from begin on to 0, up to the
+    // end of the words holding end positions.
+    void clearFrom(Word* data, int begin, int end) const {
+        int const n = words(end);
+        int w = begin >> logSlotsPerWord_;
+        if (w >= n) return;
+        int const s = slotShift(begin);
+        if (s > 0) {
+            data[w] &= (Word(1) << s) - 1;
+            ++w;
+        }
+        for (; w < n; ++w) {
+            data[w] = 0;
+        }
+    }
+};
+
+#endif // FRONTIER_BIT_LAYOUT_HPP
@@ -26,7 +26,9 @@ private:
     // make subgraphs connected or not
     const bool is_connected_;
 
-    const FrontierManager fm_;
+    // fm_ is *fm_ptr_, which may be shared with other specs
+    const FrontierManagerPtr fm_ptr_;
+    const FrontierManager& fm_;
 
     const int fixedDegStart_;
     const std::vector<IntSubset*> degRanges_;
@@ -115,12 +117,14 @@ private:
 public:
     FrontierDegreeDistributionSpec(const tdzdd::Graph& graph,
                                 const std::vector<IntSubset*>& degRanges,
-                                const bool is_connected)
+                                const bool is_connected,
+                                FrontierManagerPtr fm = FrontierManagerPtr())
         : graph_(graph),
             n_(static_cast<short>(graph_.vertexSize())),
             m_(graph_.edgeSize()),
             is_connected_(is_connected),
-            fm_(graph_),
+            fm_ptr_(FrontierManager::share(graph_, fm)),
+            fm_(*fm_ptr_),
             fixedDegStart_(is_connected ? (fm_.getMaxFrontierSize() * 2) :
                                             fm_.getMaxFrontierSize()),
             degRanges_(degRanges),
@@ -20,7 +20,9 @@ private:
     // number of edges
     const int m_;
 
-    const FrontierManager fm_;
+    // fm_ is *fm_ptr_, which may be shared with other specs
+    const FrontierManagerPtr fm_ptr_;
+    const FrontierManager& fm_;
 
     // This function gets comp of v.
     ushort getComp(FrontierForestData* data, short v) const {
@@ -39,11 +41,13 @@ private:
     }
 
 public:
-    FrontierForestSpec(const tdzdd::Graph& graph)
+    FrontierForestSpec(const tdzdd::Graph& graph,
+                       FrontierManagerPtr fm = FrontierManagerPtr())
         : graph_(graph),
           n_(static_cast<short>(graph_.vertexSize())),
           m_(graph_.edgeSize()),
-          fm_(graph_)
+          fm_ptr_(FrontierManager::share(graph_, fm)),
+          fm_(*fm_ptr_)
     {
         if (n_ >= (1 << 16)) {
             std::cerr << "The number of vertices must be smaller than 2^15."
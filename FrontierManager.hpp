@@ -1,10 +1,20 @@
 #ifndef __FRONTIER_MANAGER_HPP
 #define __FRONTIER_MANAGER_HPP
 
+#include <algorithm>
+#include <cassert>
+#include <memory>
 #include <vector>
 
 using namespace tdzdd;
 
+class FrontierManager;
+
+// A FrontierManager is immutable once built, so one instance per graph
+// (and edge order) is shared by pointer among the specs using it, the
+// copies DdBuilder and DdBuilderMP make of them and the worker threads.
+typedef std::shared_ptr<const FrontierManager> FrontierManagerPtr;
+
 // This class manages vertex numbers on the frontier
 // and where deg/comp of each vertex is stored.
 class FrontierManager {
@@ -33,7 +43,29 @@ private:
 
     // translate the vertex number to the position in the PodArray
     std::vector<int> vertex_to_pos_;
-    std::vector<std::vector<int> > pos_to_vertex_;
+
+    // A position is reused once its vertex leaves, so it holds a sequence
+    // of vertices over the edges. pos_vertices_[pos_begin_[p] ..
+    // pos_begin_[p + 1]) lists the vertices given position p in the order
+    // they entered; entering_level_[v] is the edge at which v entered.
+    // These replace a table of the vertex at every position after every
+    // edge, which took O(m n) memory.
+    std::vector<int> pos_begin_;
+    std::vector<int> pos_vertices_;
+    std::vector<int> entering_level_;
+
+    // leaving_level_[v] is the edge after which v leaves. v is on the
+    // frontier of exactly the edges from entering_level_[v] to
+    // leaving_level_[v], so these two arrays answer a frontier membership
+    // query in O(1) without a bitmask per edge.
+    std::vector<int> leaving_level_;
+
+    // the last edge at which a vertex enters, or -1 if there is no edge
+    int all_entering_level_;
+
+    // pos_bound_[i] is one more than the largest position of the vertices
+    // remaining after the i-th edge (0 if none remains)
+    std::vector<int> pos_bound_;
 
     // the maximum frontier size
     int max_frontier_size_;
@@ -46,34 +78,32 @@ private:
         leaving_vss_.resize(m);
 
         // compute entering_vss_
-        std::set<int> entered_vs;
+        std::vector<bool> entered(n + 1, false);
         for (int i = 0; i < m; ++i) {
             const tdzdd::Graph::EdgeInfo& e = graph_.edgeInfo(i);
-            if (entered_vs.count(e.v1) == 0) {
+            if (!entered[e.v1]) {
                 entering_vss_[i].push_back(e.v1);
-                entered_vs.insert(e.v1);
+                entered[e.v1] = true;
             }
-            if (entered_vs.count(e.v2) == 0) {
+            if (!entered[e.v2]) {
                 entering_vss_[i].push_back(e.v2);
-                entered_vs.insert(e.v2);
+                entered[e.v2] = true;
             }
         }
-        assert(static_cast<int>(entered_vs.size()) == n);
 
         // compute leaving_vss_
-        std::set<int> left_vs;
+        std::vector<bool> left(n + 1, false);
         for (int i = m - 1; i >= 0; --i) {
             const tdzdd::Graph::EdgeInfo& e = graph_.edgeInfo(i);
-            if (left_vs.count(e.v1) == 0) {
+            if (!left[e.v1]) {
                 leaving_vss_[i].push_back(e.v1);
-                left_vs.insert(e.v1);
+                left[e.v1] = true;
             }
-            if (left_vs.count(e.v2) == 0) {
+            if (!left[e.v2]) {
                 leaving_vss_[i].push_back(e.v2);
-                left_vs.insert(e.v2);
+                left[e.v2] = true;
             }
         }
-        assert(static_cast<int>(left_vs.size()) == n);
     }
 
     void construct() {
@@ -81,77 +111,121 @@ private:
         const int m = graph_.edgeSize();
         max_frontier_size_ = 0;
 
-        constructEnteringAndLeavingVss();
+        // positions freed by leaving vertices, reused last freed first;
+        // otherwise the smallest position never used
+        std::vector<int> freed;
+        int fresh = 0;
 
-        std::vector<int> unused;
-        for (int i = n - 1; i >= 0; --i) {
-            unused.push_back(i);
-        }
+        vertex_to_pos_.assign(n + 1, 0);
+        entering_level_.assign(n + 1, -1);
+        leaving_level_.assign(n + 1, -1);
+        all_entering_level_ = -1;
+        frontier_vss_.resize(m);
+        remaining_vss_.resize(m);
+        pos_bound_.assign(m, 0);
 
-        vertex_to_pos_.resize(n + 1);
-        pos_to_vertex_.resize(m);
+        std::vector<int> entering;
         for (int i = 0; i < m; ++i) {
-            pos_to_vertex_[i].resize(n + 1);
-        }
-
-        std::set<int> current_vs;
-        for (int i = 0; i < m; ++i) {
-            if (i > 0) {
-                for (int j = 0; j < n + 1; ++j) {
-                    pos_to_vertex_[i][j] = pos_to_vertex_[i - 1][j];
-                }
-            }
             const std::vector<int>& entering_vs = entering_vss_[i];
             for (size_t j = 0; j < entering_vs.size(); ++j) {
                 int v = entering_vs[j];
-                current_vs.insert(v);
-                int u = unused.back();
-                unused.pop_back();
+                int u;
+                if (freed.empty()) {
+                    u = fresh++;
+                } else {
+                    u = freed.back();
+                    freed.pop_back();
+                }
                 vertex_to_pos_[v] = u;
-                pos_to_vertex_[i][u] = v;
+                entering_level_[v] = i;
+                all_entering_level_ = i;
             }
 
-            if (static_cast<int>(current_vs.size()) > max_frontier_size_) {
-                max_frontier_size_ = current_vs.size();
+            // the frontier is the sorted union of the vertices remaining
+            // after the previous edge and the entering ones
+            entering.assign(entering_vs.begin(), entering_vs.end());
+            std::sort(entering.begin(), entering.end());
+            std::vector<int>& vs = frontier_vss_[i];
+            if (i > 0) {
+                const std::vector<int>& prev = remaining_vss_[i - 1];
+                vs.resize(prev.size() + entering.size());
+                std::merge(prev.begin(), prev.end(),
+                           entering.begin(), entering.end(), vs.begin());
+            } else {
+                vs = entering;
             }
 
-            const std::vector<int>& leaving_vs = leaving_vss_[i];
+            if (static_cast<int>(vs.size()) > max_frontier_size_) {
+                max_frontier_size_ = vs.size();
+            }
 
-            frontier_vss_.push_back(std::vector<int>());
-            std::vector<int>& vs = frontier_vss_.back();
-            remaining_vss_.push_back(std::vector<int>());
-            std::vector<int>& rs = remaining_vss_.back();
-            for (std::set<int>::const_iterator itor = current_vs.begin();
-                 itor != current_vs.end(); ++itor) {
-
-                vs.push_back(*itor);
-
-                bool found_leaving = false;
-                for (size_t j = 0; j < leaving_vs.size(); ++j) {
-                    int v = leaving_vs[j];
-                    if (v == *itor) {
-                        found_leaving = true;
-                        break;
-                    }
-                }
-                if (!found_leaving) {
-                    rs.push_back(*itor);
+            const std::vector<int>& leaving_vs = leaving_vss_[i];
+            for (size_t j = 0; j < leaving_vs.size(); ++j) {
+                leaving_level_[leaving_vs[j]] = i;
+            }
+            std::vector<int>& rs = remaining_vss_[i];
+            rs.reserve(vs.size() - leaving_vs.size());
+            for (size_t j = 0; j < vs.size(); ++j) {
+                if (leaving_level_[vs[j]] != i) {
+                    rs.push_back(vs[j]);
+                    pos_bound_[i] = std::max(pos_bound_[i],
+                                             vertex_to_pos_[vs[j]] + 1);
                 }
             }
 
             for (size_t j = 0; j < leaving_vs.size(); ++j) {
-                int v = leaving_vs[j];
-                current_vs.erase(v);
-                unused.push_back(vertex_to_pos_[v]);
+                freed.push_back(vertex_to_pos_[leaving_vs[j]]);
+            }
+        }
+
+        // group the vertices by position, each group in entering order
+        pos_begin_.assign(fresh + 1, 0);
+        for (int v = 1; v <= n; ++v) {
+            if (entering_level_[v] >= 0) ++pos_begin_[vertex_to_pos_[v] + 1];
+        }
+        for (int p = 0; p < fresh; ++p) {
+            pos_begin_[p + 1] += pos_begin_[p];
+        }
+        pos_vertices_.resize(pos_begin_[fresh]);
+        std::vector<int> next(pos_begin_.begin(), pos_begin_.end() - 1);
+        for (int i = 0; i < m; ++i) {
+            const std::vector<int>& entering_vs = entering_vss_[i];
+            for (size_t j = 0; j < entering_vs.size(); ++j) {
+                int v = entering_vs[j];
+                pos_vertices_[next[vertex_to_pos_[v]]++] = v;
             }
         }
     }
 
+    FrontierManager(const FrontierManager&) = delete;
+    FrontierManager& operator=(const FrontierManager&) = delete;
+
 public:
     FrontierManager(const tdzdd::Graph& graph) : graph_(graph) {
+        constructEnteringAndLeavingVss();
         construct();
     }
 
+    // This constructor takes the entering and leaving vertices of each
+    // edge, computed before for the same graph (e.g., loaded from a cache).
+    FrontierManager(const tdzdd::Graph& graph,
+                    const std::vector<std::vector<int> >& entering_vss,
+                    const std::vector<std::vector<int> >& leaving_vss)
+        : graph_(graph), entering_vss_(entering_vss), leaving_vss_(leaving_vss) {
+        assert(static_cast<int>(entering_vss_.size()) == graph_.edgeSize());
+        assert(static_cast<int>(leaving_vss_.size()) == graph_.edgeSize());
+        construct();
+    }
+
+    // This function returns fm if given, which must be a manager of
+    // graph, or builds a new manager of graph to be shared from now on.
+    static FrontierManagerPtr share(const tdzdd::Graph& graph,
+                                    const FrontierManagerPtr& fm) {
+        if (!fm) return std::make_shared<const FrontierManager>(graph);
+        assert(&fm->graph_ == &graph);
+        return fm;
+    }
+
     // This function returns the maximum frontier size.
     int getMaxFrontierSize() const {
         return max_frontier_size_;
@@ -181,39 +255,74 @@ public:
         return remaining_vss_[index];
     }
 
+    // This function returns a bound on the positions in use between the
+    // (index)-th edge and the next one: the vertices remaining after the
+    // (index)-th edge all have positions less than it. A spec whose
+    // state is indexed by position only needs that prefix of its array
+    // at the level of the next edge.
+    int getPositionBound(int index) const {
+        return pos_bound_[index];
+    }
+
     // This function translates the vertex number to the position
     // in the PodArray used by FrontierExampleSpec.
     int vertexToPos(int v) const {
         return vertex_to_pos_[v];
     }
 
+    // This function returns the vertex at position pos when processing
+    // the (index)-th edge: the last vertex given pos at or before that
+    // edge (which may have left already), or 0 if there is none.
     int posToVertex(int index, int pos) const {
-        return pos_to_vertex_[index][pos];
+        if (pos + 1 >= static_cast<int>(pos_begin_.size())) return 0;
+        int lo = pos_begin_[pos];
+        int hi = pos_begin_[pos + 1];
+        // the vertices of a position entered at increasing edges
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (entering_level_[pos_vertices_[mid]] <= index) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo > pos_begin_[pos] ? pos_vertices_[lo - 1] : 0;
     }
 
+    // This function returns the index of the edge at which v enters
+    // the frontier, or -1 if v is on no edge.
     int getVerticesEnteringLevel(short v) const {
-        for (size_t i = 0; i < entering_vss_.size(); ++i) {
-            for (size_t j = 0; j < entering_vss_[i].size(); ++j) {
-                if (entering_vss_[i][j] == v) {
-                    return static_cast<int>(i);
-                }
-            }
-        }
-        return -1;
+        return entering_level_[v];
+    }
+
+    // This function returns the index of the edge after which v leaves
+    // the frontier, or -1 if v is on no edge.
+    int getVerticesLeavingLevel(short v) const {
+        return leaving_level_[v];
     }
 
+    // This function returns the index of the last edge at which a vertex
+    // enters the frontier, or -1 if there is no edge.
     int getAllVerticesEnteringLevel() const {
-        int n = static_cast<int>(entering_vss_.size());
+        return all_entering_level_;
+    }
 
-        for (int i = n - 1; i >= 0; --i) {
-            if (entering_vss_[i].size() > 0) {
-                return i;
-            }
-        }
-        return -1;
+    // This function returns whether v is on the frontier when processing
+    // the (index)-th edge, i.e., whether v is in getFrontierVs(index).
+    bool isOnFrontier(int index, int v) const {
+        return entering_level_[v] >= 0 && entering_level_[v] <= index
+                && index <= leaving_level_[v];
+    }
+
+    // This function returns whether v remains on the frontier after the
+    // (index)-th edge is processed, i.e., whether v is in
+    // getRemainingVs(index).
+    bool isRemaining(int index, int v) const {
+        return entering_level_[v] >= 0 && entering_level_[v] <= index
+                && index < leaving_level_[v];
     }
 
-    void print() {
+    void print() const {
         for (int i = 0; i < graph_.edgeSize(); ++i) {
             std::cout << "[";
             for (size_t j = 0; j < entering_vss_[i].size(); ++j) {
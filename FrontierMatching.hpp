@@ -21,7 +21,9 @@ private:
 
     const bool isComplete_;
 
-    const FrontierManager fm_;
+    // fm_ is *fm_ptr_, which may be shared with other specs
+    const FrontierManagerPtr fm_ptr_;
+    const FrontierManager& fm_;
 
     bool getUsed(FrontierMatchingData* data, int v) const {
         return ((data[(v - 1) / 8] >> ((v - 1) % 8)) & 1u) != 0;
@@ -43,12 +45,14 @@ private:
 
 public:
     FrontierMatchingSpec(const tdzdd::Graph& graph,
-                         bool isComplete) : graph_(graph),
+                         bool isComplete,
+                         FrontierManagerPtr fm = FrontierManagerPtr()) : graph_(graph),
                                             n_(graph_.vertexSize()),
                                             m_(graph_.edgeSize()),
                                             dataSize_((n_ - 1) / 8 + 1),
                                             isComplete_(isComplete),
-                                            fm_(graph_)
+                                            fm_ptr_(FrontierManager::share(graph_, fm)),
+                                            fm_(*fm_ptr_)
     {
         setArraySize(dataSize_);
     }
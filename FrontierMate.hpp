@@ -26,7 +26,9 @@ private:
     const short s_;
     const short t_;
 
-    const FrontierManager fm_;
+    // fm_ is *fm_ptr_, which may be shared with other specs
+    const FrontierManagerPtr fm_ptr_;
+    const FrontierManager& fm_;
 
     const int s_entered_level_;
     const int t_entered_level_;
@@ -57,7 +59,8 @@ private:
 public:
     // for cycles
     FrontierMateSpec(const tdzdd::Graph& graph,
-                     bool isHamiltonian)
+                     bool isHamiltonian,
+                     FrontierManagerPtr fm = FrontierManagerPtr())
         : graph_(graph),
           n_(static_cast<short>(graph_.vertexSize())),
           m_(graph_.edgeSize()),
@@ -65,7 +68,8 @@ public:
           isHamiltonian_(isHamiltonian),
           s_(-1),
           t_(-1),
-          fm_(graph_),
+          fm_ptr_(FrontierManager::share(graph_, fm)),
+          fm_(*fm_ptr_),
           s_entered_level_(-1),
           t_entered_level_(-1),
           all_entered_level_(m_ - fm_.getAllVerticesEnteringLevel())
@@ -80,7 +84,8 @@ public:
 
     // for paths
     FrontierMateSpec(const tdzdd::Graph& graph,
-                     bool isHamiltonian, int s, int t)
+                     bool isHamiltonian, int s, int t,
+                     FrontierManagerPtr fm = FrontierManagerPtr())
         : graph_(graph),
           n_(static_cast<short>(graph_.vertexSize())),
           m_(graph_.edgeSize()),
@@ -88,7 +93,8 @@ public:
           isHamiltonian_(isHamiltonian),
           s_(s),
           t_(t),
-          fm_(graph_),
+          fm_ptr_(FrontierManager::share(graph_, fm)),
+          fm_(*fm_ptr_),
           s_entered_level_(computeEnteredLevel(s)),
           t_entered_level_(computeEnteredLevel(t)),
           all_entered_level_(m_ - fm_.getAllVerticesEnteringLevel())
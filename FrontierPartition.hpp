@@ -0,0 +1,166 @@
+#ifndef FRONTIER_PARTITION_HPP
+#define FRONTIER_PARTITION_HPP
+
+#include <vector>
+#include <climits>
+
+#include "FrontierManager.hpp"
+#include "tdzdd/DdSpec.hpp"
+#include "tdzdd/util/Graph.hpp"
+
+using namespace tdzdd;
+
+typedef short FrontierPartitionData;
+
+// Frontier-based search for all edge subsets, classified by rank.
+// The state is the partition of the frontier vertices into the connected
+// components of the edges taken so far. Each edge has three arcs:
+//   0-arc: the edge is not taken,
+//   1-arc: the edge is taken and joins two components (the rank grows),
+//   2-arc: the edge is taken and closes a cycle (the nullity grows).
+// Every edge subset is represented by exactly one path, and the numbers
+// of 1-arcs and 2-arcs on it are its rank and nullity.
+//
+// Components are labeled canonically: after each edge, a component is
+// labeled by the smallest remaining frontier vertex in it, so that states
+// with the same partition are shared.
+class FrontierPartitionSpec
+    : public tdzdd::PodArrayDdSpec<FrontierPartitionSpec,
+                                   FrontierPartitionData, 3> {
+private:
+    // input graph
+    const tdzdd::Graph& graph_;
+    // number of vertices
+    const int n_;
+    // number of edges
+    const int m_;
+
+    // fm_ is *fm_ptr_, which may be shared with other specs
+    const FrontierManagerPtr fm_ptr_;
+    const FrontierManager& fm_;
+
+    // This function gets comp of v.
+    short getComp(FrontierPartitionData* data, int v) const {
+        return data[fm_.vertexToPos(v)];
+    }
+
+    // This function sets comp of v to be c.
+    void setComp(FrontierPartitionData* data, int v, short c) const {
+        data[fm_.vertexToPos(v)] = c;
+    }
+
+    // Relabels every component by its smallest remaining vertex.
+    // New labels are written negated so that they are not confused with
+    // the old (positive) ones.
+    void canonicalize(FrontierPartitionData* data,
+                      const std::vector<int>& remaining_vs) const {
+        for (size_t i = 0; i < remaining_vs.size(); ++i) {
+            const short c = getComp(data, remaining_vs[i]);
+            if (c < 0) continue;
+            for (size_t j = i; j < remaining_vs.size(); ++j) {
+                if (getComp(data, remaining_vs[j]) == c) {
+                    setComp(data, remaining_vs[j],
+                            static_cast<short>(-remaining_vs[i]));
+                }
+            }
+        }
+        for (size_t i = 0; i < remaining_vs.size(); ++i) {
+            setComp(data, remaining_vs[i],
+                    static_cast<short>(-getComp(data, remaining_vs[i])));
+        }
+    }
+
+    void initializeData(FrontierPartitionData* data) const {
+        for (int i = 0; i < fm_.getMaxFrontierSize(); ++i) {
+            data[i] = 0;
+        }
+    }
+
+public:
+    FrontierPartitionSpec(const tdzdd::Graph& graph,
+                          FrontierManagerPtr fm = FrontierManagerPtr())
+        : graph_(graph),
+          n_(graph_.vertexSize()),
+          m_(graph_.edgeSize()),
+          fm_ptr_(FrontierManager::share(graph_, fm)),
+          fm_(*fm_ptr_)
+    {
+        if (n_ > SHRT_MAX) {
+            std::cerr << "The number of vertices must be smaller than 2^15."
+                      << std::endl;
+            exit(1);
+        }
+        setArraySize(fm_.getMaxFrontierSize());
+    }
+
+    int getRoot(FrontierPartitionData* data) const {
+        initializeData(data);
+        // the empty graph has only the empty edge subset
+        return (m_ == 0) ? -1 : m_;
+    }
+
+    int getChild(FrontierPartitionData* data, int level, int value) const {
+        assert(1 <= level && level <= m_);
+
+        // edge index (starting from 0)
+        const int edge_index = m_ - level;
+        // edge that we are processing.
+        // The endpoints of "edge" are edge.v1 and edge.v2.
+        const Graph::EdgeInfo& edge = graph_.edgeInfo(edge_index);
+
+        // initialize comp of the vertices newly entering the frontier
+        const std::vector<int>& entering_vs = fm_.getEnteringVs(edge_index);
+        for (size_t i = 0; i < entering_vs.size(); ++i) {
+            int v = entering_vs[i];
+            // initially the value of comp is the vertex number itself
+            setComp(data, v, static_cast<short>(v));
+        }
+
+        // vertices on the frontier
+        const std::vector<int>& frontier_vs = fm_.getFrontierVs(edge_index);
+
+        if (value != 0) { // if we take the edge
+            short c1 = getComp(data, edge.v1);
+            short c2 = getComp(data, edge.v2);
+
+            if (value == 1) { // the edge must join two components
+                if (c1 == c2) {
+                    return 0;
+                }
+                short cmin = std::min(c1, c2);
+                short cmax = std::max(c1, c2);
+
+                // replace component number cmin with cmax
+                for (size_t i = 0; i < frontier_vs.size(); ++i) {
+                    int v = frontier_vs[i];
+                    if (getComp(data, v) == cmin) {
+                        setComp(data, v, cmax);
+                    }
+                }
+            } else { // the edge must close a cycle
+                if (c1 != c2) {
+                    return 0;
+                }
+            }
+        }
+
+        // vertices that are leaving the frontier
+        const std::vector<int>& leaving_vs = fm_.getLeavingVs(edge_index);
+        for (size_t i = 0; i < leaving_vs.size(); ++i) {
+            int v = leaving_vs[i];
+
+            // Since comp of v is never used until the end,
+            // we erase the value.
+            setComp(data, v, 0);
+        }
+        canonicalize(data, fm_.getRemainingVs(edge_index));
+
+        if (level == 1) {
+            return -1;
+        }
+        assert(level - 1 > 0);
+        return level - 1;
+    }
+};
+
+#endif // FRONTIER_PARTITION_HPP
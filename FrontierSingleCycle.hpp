@@ -4,18 +4,19 @@
 #include <vector>
 #include <climits>
 
-using namespace tdzdd;
+#include "FrontierBitLayout.hpp"
 
-// data associated with each vertex on the frontier
-class FrontierData {
-public:
-    short deg;
-    short comp;
-};
+using namespace tdzdd;
 
 class FrontierSingleCycleSpec
-    : public tdzdd::PodArrayDdSpec<FrontierSingleCycleSpec, FrontierData, 2> {
+    : public tdzdd::PodArrayDdSpec<FrontierSingleCycleSpec,
+                                   FrontierBitLayout<2>::Word, 2> {
 private:
+    typedef FrontierBitLayout<2>::Word Word;
+
+    // fields associated with each vertex on the frontier
+    enum { DEG, COMP };
+
     // input graph
     const tdzdd::Graph& graph_;
     // number of vertices
@@ -23,56 +24,83 @@ private:
     // number of edges
     const int m_;
 
-    const FrontierManager fm_;
+    // fm_ is *fm_ptr_, which may be shared with other specs
+    const FrontierManagerPtr fm_ptr_;
+    const FrontierManager& fm_;
+
+    // deg (at most 2) and comp of each position. comp is a position, so
+    // it needs only log2 of the frontier size bits.
+    const FrontierBitLayout<2> layout_;
 
     // This function gets deg of v.
-    short getDeg(FrontierData* data, short v) const {
-        return data[fm_.vertexToPos(v)].deg;
+    short getDeg(const Word* data, short v) const {
+        return layout_.get(data, fm_.vertexToPos(v), DEG);
     }
 
     // This function sets deg of v to be d.
-    void setDeg(FrontierData* data, short v, short d) const {
-        data[fm_.vertexToPos(v)].deg = d;
+    void setDeg(Word* data, short v, short d) const {
+        layout_.set(data, fm_.vertexToPos(v), DEG, d);
     }
 
     // This function gets comp of v.
-    short getComp(FrontierData* data, short v) const {
-        return data[fm_.vertexToPos(v)].comp;
+    short getComp(const Word* data, short v) const {
+        return layout_.get(data, fm_.vertexToPos(v), COMP);
     }
 
     // This function sets comp of v to be c.
-    void setComp(FrontierData* data, short v, short c) const {
-        data[fm_.vertexToPos(v)].comp = c;
+    void setComp(Word* data, short v, short c) const {
+        layout_.set(data, fm_.vertexToPos(v), COMP, c);
+    }
+
+    void initializeDegComp(Word* data) const {
+        layout_.clearFrom(data, 0, fm_.getMaxFrontierSize());
     }
 
-    void initializeDegComp(FrontierData* data) const {
-        for (int i = 0; i < fm_.getMaxFrontierSize(); ++i) {
-            data[i].deg = 0;
-            data[i].comp = 0;
+    // comp of a component is the largest position of its vertices on the
+    // frontier, and the positions not in use are cleared. So when v
+    // leaves, this function renumbers its component by the largest
+    // position of its other vertices, which are all below that of v.
+    void renumberComp(Word* data, short v) const {
+        const int c = fm_.vertexToPos(v);
+        if (getComp(data, v) != c) {
+            return;
+        }
+        int c_new = -1;
+        for (int p = c - 1; p >= 0; --p) {
+            if (layout_.get(data, p, COMP) == c) {
+                if (c_new < 0) {
+                    c_new = p;
+                }
+                layout_.set(data, p, COMP, c_new);
+            }
         }
     }
 
 public:
-    FrontierSingleCycleSpec(const tdzdd::Graph& graph)
+    FrontierSingleCycleSpec(const tdzdd::Graph& graph,
+                            FrontierManagerPtr fm = FrontierManagerPtr())
         : graph_(graph),
           n_(static_cast<short>(graph_.vertexSize())),
           m_(graph_.edgeSize()),
-          fm_(graph_)
+          fm_ptr_(FrontierManager::share(graph_, fm)),
+          fm_(*fm_ptr_),
+          layout_({2, FrontierBitLayout<2>::bitsFor(
+                  fm_.getMaxFrontierSize() - 1)})
     {
         if (graph_.vertexSize() > SHRT_MAX) { // SHRT_MAX == 32767
             std::cerr << "The number of vertices should be at most "
                       << SHRT_MAX << std::endl;
             exit(1);
         }
-        setArraySize(fm_.getMaxFrontierSize());
+        setArraySize(layout_.words(fm_.getMaxFrontierSize()));
     }
 
-    int getRoot(FrontierData* data) const {
+    int getRoot(Word* data) const {
         initializeDegComp(data);
         return m_;
     }
 
-    int getChild(FrontierData* data, int level, int value) const {
+    int getChild(Word* data, int level, int value) const {
         assert(1 <= level && level <= m_);
 
         // edge index (starting from 0)
@@ -87,16 +115,24 @@ public:
             int v = entering_vs[i];
             // initially the value of deg is 0
             setDeg(data, v, 0);
-            // initially the value of comp is the vertex number itself
-            setComp(data, v, v);
+            // initially the value of comp is the position of the vertex
+            setComp(data, v, fm_.vertexToPos(v));
         }
 
         // vertices on the frontier
         const std::vector<int>& frontier_vs = fm_.getFrontierVs(edge_index);
 
         if (value == 1) { // if we take the edge (go to 1-arc)
-            // increment deg of v1 and v2 (recall that edge = {v1, v2})
+            // increment deg of v1 and v2 (recall that edge = {v1, v2}).
+            // A vertex of degree more than 2 is never on a cycle, so
+            // deg never exceeds 2.
+            if (getDeg(data, edge.v1) >= 2) {
+                return 0;
+            }
             setDeg(data, edge.v1, getDeg(data, edge.v1) + 1);
+            if (getDeg(data, edge.v2) >= 2) {
+                return 0;
+            }
             setDeg(data, edge.v2, getDeg(data, edge.v2) + 1);
 
             short c1 = getComp(data, edge.v1);
@@ -183,10 +219,10 @@ public:
                     }
                 }
             }
+            renumberComp(data, v);
             // Since deg and comp of v are never used until the end,
             // we erase the values.
-            setDeg(data, v, -1);
-            setComp(data, v, -1);
+            layout_.clear(data, fm_.vertexToPos(v));
         }
         if (level == 1) {
             // If we come here, the edge set is empty (taking no edge).
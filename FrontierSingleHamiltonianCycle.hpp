@@ -23,7 +23,9 @@ private:
     // number of edges
     const int m_;
 
-    const FrontierManager fm_;
+    // fm_ is *fm_ptr_, which may be shared with other specs
+    const FrontierManagerPtr fm_ptr_;
+    const FrontierManager& fm_;
 
     // the level where all vertices enter the frontier
     const int all_entered_level_;
@@ -56,11 +58,13 @@ private:
     }
 
 public:
-    FrontierSingleHamiltonianCycleSpec(const tdzdd::Graph& graph)
+    FrontierSingleHamiltonianCycleSpec(const tdzdd::Graph& graph,
+                                       FrontierManagerPtr fm = FrontierManagerPtr())
         : graph_(graph),
           n_(static_cast<short>(graph_.vertexSize())),
           m_(graph_.edgeSize()),
-          fm_(graph_),
+          fm_ptr_(FrontierManager::share(graph_, fm)),
+          fm_(*fm_ptr_),
           all_entered_level_(m_ - fm_.getAllVerticesEnteringLevel())
     {
         if (graph_.vertexSize() > SHRT_MAX) { // SHRT_MAX == 32767
@@ -4,15 +4,21 @@
 #include <vector>
 #include <climits>
 
+#include "FrontierBitLayout.hpp"
+
 using namespace tdzdd;
 
 typedef unsigned short ushort;
 
-typedef unsigned short FrontierTreeData;
-
 class FrontierTreeSpec
-    : public tdzdd::PodArrayDdSpec<FrontierTreeSpec, FrontierTreeData, 2> {
+    : public tdzdd::PodArrayDdSpec<FrontierTreeSpec,
+                                   FrontierBitLayout<2>::Word, 2> {
 private:
+    typedef FrontierBitLayout<2>::Word Word;
+
+    // fields associated with each vertex on the frontier
+    enum { DEG, COMP };
+
     // input graph
     const tdzdd::Graph& graph_;
     // number of vertices
@@ -22,62 +28,84 @@ private:
 
     const bool isSpanning_;
 
-    const FrontierManager fm_;
+    // fm_ is *fm_ptr_, which may be shared with other specs
+    const FrontierManagerPtr fm_ptr_;
+    const FrontierManager& fm_;
 
-    // This function gets whether the degree of v is at least 1 or not.
-    bool getDeg(FrontierTreeData* data, short v) const {
-        return ((data[fm_.vertexToPos(v)] >> 15) & 1u) != 0;
-    }
+    // whether deg is at least 1 (1 bit) and comp of each position. comp
+    // is a position, so it needs only log2 of the frontier size bits.
+    const FrontierBitLayout<2> layout_;
 
-    // This function sets deg of v to be d.
-    void setDeg(FrontierTreeData* data, short v) const {
-        data[fm_.vertexToPos(v)] |= (1u << 15);
+    // This function gets whether the degree of v is at least 1 or not.
+    bool getDeg(const Word* data, short v) const {
+        return layout_.get(data, fm_.vertexToPos(v), DEG) != 0;
     }
 
     // This function sets deg of v to be d.
-    void resetDeg(FrontierTreeData* data, short v) const {
-        data[fm_.vertexToPos(v)] &= ~(1u << 15);
+    void setDeg(Word* data, short v) const {
+        layout_.set(data, fm_.vertexToPos(v), DEG, 1);
     }
 
     // This function gets comp of v.
-    ushort getComp(FrontierTreeData* data, short v) const {
-        return data[fm_.vertexToPos(v)] & 0x7fffu;
+    ushort getComp(const Word* data, short v) const {
+        return layout_.get(data, fm_.vertexToPos(v), COMP);
     }
 
     // This function sets comp of v to be c.
-    void setComp(FrontierTreeData* data, short v, ushort c) const {
-        assert(c < 0x8000u);
-        data[fm_.vertexToPos(v)] = (0x8000u & data[fm_.vertexToPos(v)]) | c;
+    void setComp(Word* data, short v, ushort c) const {
+        layout_.set(data, fm_.vertexToPos(v), COMP, c);
+    }
+
+    void initializeData(Word* data) const {
+        layout_.clearFrom(data, 0, fm_.getMaxFrontierSize());
     }
 
-    void initializeData(FrontierTreeData* data) const {
-        for (int i = 0; i < fm_.getMaxFrontierSize(); ++i) {
-            data[i] = 0;
+    // comp of a component is the largest position of its vertices on the
+    // frontier, and the positions not in use are cleared. So when v
+    // leaves, this function renumbers its component by the largest
+    // position of its other vertices, which are all below that of v.
+    void renumberComp(Word* data, short v) const {
+        const int c = fm_.vertexToPos(v);
+        if (getComp(data, v) != c) {
+            return;
+        }
+        int c_new = -1;
+        for (int p = c - 1; p >= 0; --p) {
+            if (layout_.get(data, p, COMP) == c) {
+                if (c_new < 0) {
+                    c_new = p;
+                }
+                layout_.set(data, p, COMP, c_new);
+            }
         }
     }
 
 public:
     FrontierTreeSpec(const tdzdd::Graph& graph,
-                     bool isSpanning) : graph_(graph),
+                     bool isSpanning,
+                     FrontierManagerPtr fm = FrontierManagerPtr()) : graph_(graph),
                                         n_(graph_.vertexSize()),
                                         m_(graph_.edgeSize()),
                                         isSpanning_(isSpanning),
-                                        fm_(graph_)
+                                        fm_ptr_(FrontierManager::share(graph_, fm)),
+                                        fm_(*fm_ptr_),
+                                        layout_({1, FrontierBitLayout<2>::bitsFor(
+                                                fm_.getMaxFrontierSize() - 1)})
     {
         if (n_ >= (1 << 15)) {
             std::cerr << "The number of vertices must be smaller than 2^15."
                       << std::endl;
             exit(1);
         }
-        setArraySize(fm_.getMaxFrontierSize());
+        setArraySize(layout_.words(fm_.getMaxFrontierSize()));
     }
 
-    int getRoot(FrontierTreeData* data) const {
+    int getRoot(Word* data) const {
         initializeData(data);
         return m_;
     }
 
-    int getChild(FrontierTreeData* data, int level, int value) const {
+    int getChild(Word* data, int level, int value) const {
         assert(1 <= level && level <= m_);
 
         // edge index (starting from 0)
@@ -90,8 +118,8 @@ public:
         const std::vector<int>& entering_vs = fm_.getEnteringVs(edge_index);
         for (size_t i = 0; i < entering_vs.size(); ++i) {
             int v = entering_vs[i];
-            // initially the value of comp is the vertex number itself
-            setComp(data, v, static_cast<ushort>(v));
+            // initially the value of comp is the position of the vertex
+            setComp(data, v, static_cast<ushort>(fm_.vertexToPos(v)));
         }
 
         // vertices on the frontier
@@ -205,10 +233,10 @@ public:
                 }
             }
 
+            renumberComp(data, v);
             // Since deg and comp of v are never used until the end,
             // we erase the values.
-            resetDeg(data, v);
-            setComp(data, v, 0);
+            layout_.clear(data, fm_.vertexToPos(v));
         }
         if (level == 1) {
             // If we come here, the edge set is empty (taking no edge).
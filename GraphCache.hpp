@@ -0,0 +1,365 @@
+#ifndef GRAPH_CACHE_HPP
+#define GRAPH_CACHE_HPP
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "FrontierManager.hpp"
+#include "tdzdd/util/Graph.hpp"
+#include "tdzdd/util/MessageHandler.hpp"
+
+// Binary cache of an input graph, kept next to the input as <input>.tdzc.
+// It holds what every run derives from the text before building any
+// diagram, in the form the graph and the frontier tables use: the vertex
+// names, the edges as Graph::update() numbers them (in the input order or
+// the one chosen by EdgeOrder, as flagged in the header), the adjacency
+// index, the vertices entering and leaving the frontier at each edge, and
+// the block decomposition. load() maps the file and accepts it only if its
+// version, its edge order flag and the size and modification time of the
+// input it was made from still match; the graph then adopts the arrays
+// as they are, without update(). Otherwise the caller reads the text and
+// calls save().
+//
+// Layout (native byte order), every section padded to 8 bytes:
+//   Header
+//   names           n NUL-terminated vertex names, vertex 1 first
+//   edgeInfo        Graph::EdgeInfo x m, as laid out in memory
+//   reversed        uint8 x m, whether edge a was named as (v2, v1)
+//   adjacency       int32 offsets x (n + 2), then int32 vertices and
+//                   int32 edges, as returned by Graph::neighbors()
+//   entering        int32 offsets x (m + 1), then int32 vertices
+//   leaving         int32 offsets x (m + 1), then int32 vertices
+//   blockOf         int32 x m
+//   isBridge        uint8 x m
+//   isArticulation  uint8 x (n + 1)
+class GraphCache {
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t vertices;
+        uint64_t edges;
+        uint64_t sourceSize;
+        // nanoseconds since the epoch
+        int64_t sourceTime;
+        uint64_t nameBytes;
+        uint64_t adjacencySize;
+        uint64_t enteringSize;
+        uint64_t leavingSize;
+        int32_t numBlocks;
+        // ORDERED if the edges were put in the order of EdgeOrder
+        uint32_t flags;
+        // sizeof(Graph::EdgeInfo) of the writer
+        uint32_t edgeInfoSize;
+    };
+
+    static char const* magic() {
+        return "TDZGRAPH";
+    }
+
+    static uint64_t padded(uint64_t bytes) {
+        return (bytes + 7) & ~uint64_t(7);
+    }
+
+    static bool sourceStamp(std::string const& input, uint64_t& size,
+                            int64_t& time) {
+        struct stat st;
+        if (stat(input.c_str(), &st) != 0) return false;
+        size = st.st_size;
+        time = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+        return true;
+    }
+
+    // Walks the sections of a mapped file, refusing to run past its end.
+    class Cursor {
+        char const* p_;
+        char const* end_;
+
+    public:
+        Cursor(char const* p, char const* end)
+            : p_(p), end_(end) {
+        }
+
+        template<typename T>
+        T const* take(uint64_t count) {
+            uint64_t bytes = padded(count * sizeof(T));
+            if (bytes > uint64_t(end_ - p_)) return 0;
+            T const* t = reinterpret_cast<T const*>(p_);
+            p_ += bytes;
+            return t;
+        }
+
+        bool atEnd() const {
+            return p_ == end_;
+        }
+    };
+
+    template<typename T>
+    static void put(std::ofstream& os, T const* data, uint64_t count) {
+        uint64_t bytes = count * sizeof(T);
+        if (bytes > 0) os.write(reinterpret_cast<char const*>(data), bytes);
+        char const zero[8] = {0};
+        os.write(zero, padded(bytes) - bytes);
+    }
+
+    static void putTable(std::ofstream& os, FrontierManager const& fm,
+                         int m, bool entering) {
+        std::vector<int32_t> offset(m + 1, 0);
+        std::vector<int32_t> vertex;
+        for (int i = 0; i < m; ++i) {
+            std::vector<int> const& vs =
+                    entering ? fm.getEnteringVs(i) : fm.getLeavingVs(i);
+            vertex.insert(vertex.end(), vs.begin(), vs.end());
+            offset[i + 1] = vertex.size();
+        }
+        put(os, offset.data(), offset.size());
+        put(os, vertex.data(), vertex.size());
+    }
+
+    static bool takeTable(Cursor& c, int m, uint64_t size,
+                          std::vector<std::vector<int> >& table) {
+        int32_t const* offset = c.take<int32_t>(m + 1);
+        int32_t const* vertex = c.take<int32_t>(size);
+        if (!offset || !vertex || offset[0] != 0 || uint64_t(offset[m]) != size) {
+            return false;
+        }
+        table.assign(m, std::vector<int>());
+        for (int i = 0; i < m; ++i) {
+            if (offset[i + 1] < offset[i]) return false;
+            table[i].assign(vertex + offset[i], vertex + offset[i + 1]);
+        }
+        return true;
+    }
+
+    static bool read(char const* p, char const* end, uint64_t sourceSize,
+                     int64_t sourceTime, uint32_t flags, tdzdd::Graph& graph,
+                     std::vector<std::vector<int> >& entering,
+                     std::vector<std::vector<int> >& leaving) {
+        typedef tdzdd::Graph::EdgeInfo EdgeInfo;
+        Cursor c(p, end);
+        Header const* h = c.take<Header>(1);
+        if (!h || std::memcmp(h->magic, magic(), 8) != 0
+                || h->version != VERSION || h->sourceSize != sourceSize
+                || h->sourceTime != sourceTime || h->flags != flags
+                || h->edgeInfoSize != sizeof(EdgeInfo)) {
+            return false;
+        }
+        const int n = h->vertices;
+        const int m = h->edges;
+
+        char const* nameBytes = c.take<char>(h->nameBytes);
+        EdgeInfo const* edgeInfo = c.take<EdgeInfo>(m);
+        uint8_t const* reversed = c.take<uint8_t>(m);
+        int32_t const* adjOffset = c.take<int32_t>(n + 2);
+        int32_t const* adjVertex = c.take<int32_t>(h->adjacencySize);
+        int32_t const* adjEdge = c.take<int32_t>(h->adjacencySize);
+        if (!nameBytes || !edgeInfo || !reversed || !adjOffset || !adjVertex
+                || !adjEdge) {
+            return false;
+        }
+
+        std::vector<std::string> names;
+        names.reserve(n + 1);
+        names.push_back(""); // vertex numbers begin with 1
+        for (char const* s = nameBytes;
+                s < nameBytes + h->nameBytes && int(names.size()) <= n;) {
+            size_t len = strnlen(s, nameBytes + h->nameBytes - s);
+            names.push_back(std::string(s, len));
+            s += len + 1;
+        }
+        if (int(names.size()) != n + 1) return false;
+
+        for (int a = 0; a < m; ++a) {
+            EdgeInfo const& e = edgeInfo[a];
+            if (e.v0 < 1 || e.v0 > n || e.v1 < 1 || e.v1 > e.v2 || e.v2 > n) {
+                return false;
+            }
+        }
+        if (adjOffset[0] != 0
+                || uint64_t(adjOffset[n + 1]) != h->adjacencySize) {
+            return false;
+        }
+        for (int v = 0; v <= n; ++v) {
+            if (adjOffset[v + 1] < adjOffset[v]) return false;
+        }
+        for (uint64_t k = 0; k < h->adjacencySize; ++k) {
+            if (adjVertex[k] < 1 || adjVertex[k] > n || adjEdge[k] < 0
+                    || adjEdge[k] >= m) {
+                return false;
+            }
+        }
+
+        if (!takeTable(c, m, h->enteringSize, entering)) return false;
+        if (!takeTable(c, m, h->leavingSize, leaving)) return false;
+
+        tdzdd::Graph::BlockDecomposition blocks;
+        int32_t const* blockOf = c.take<int32_t>(m);
+        uint8_t const* isBridge = c.take<uint8_t>(m);
+        uint8_t const* isArticulation = c.take<uint8_t>(n + 1);
+        if (!blockOf || !isBridge || !isArticulation || !c.atEnd()) {
+            return false;
+        }
+        blocks.blockOf.assign(blockOf, blockOf + m);
+        blocks.isBridge.assign(isBridge, isBridge + m);
+        blocks.isArticulation.assign(isArticulation, isArticulation + n + 1);
+        blocks.numBlocks = h->numBlocks;
+
+        graph.setUpdatedState(
+                std::move(names),
+                std::vector<EdgeInfo>(edgeInfo, edgeInfo + m),
+                std::vector<bool>(reversed, reversed + m),
+                std::vector<int>(adjOffset, adjOffset + n + 2),
+                std::vector<int>(adjVertex, adjVertex + h->adjacencySize),
+                std::vector<int>(adjEdge, adjEdge + h->adjacencySize));
+        graph.setBlockDecomposition(blocks);
+        return true;
+    }
+
+public:
+    static uint32_t const VERSION = 2;
+    static uint32_t const ORDERED = 1;
+
+    static std::string path(std::string const& input) {
+        return input + ".tdzc";
+    }
+
+    // Loads the cache of input into graph and the frontier tables, with
+    // the edges reordered if ordered. Returns false, leaving graph to be
+    // read from input, if there is no valid cache for input as it is now.
+    static bool load(std::string const& input, bool ordered,
+                     tdzdd::Graph& graph,
+                     std::vector<std::vector<int> >& entering,
+                     std::vector<std::vector<int> >& leaving) {
+        uint64_t sourceSize;
+        int64_t sourceTime;
+        if (!sourceStamp(input, sourceSize, sourceTime)) return false;
+
+        std::string const file = path(input);
+        int fd = open(file.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < off_t(sizeof(Header))) {
+            close(fd);
+            return false;
+        }
+        size_t const size = st.st_size;
+        void* map = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) return false;
+
+        tdzdd::MessageHandler mh;
+        mh.begin("reading");
+        mh << " \"" << file << "\" ...";
+        char const* p = static_cast<char const*>(map);
+        bool ok = read(p, p + size, sourceSize, sourceTime,
+                       ordered ? ORDERED : 0, graph, entering, leaving);
+        munmap(map, size);
+        mh.end(ok ? "done" : "stale");
+        return ok;
+    }
+
+    // Writes the cache of input, which graph was read from (and whose
+    // edges were reordered if ordered). Returns false if the file cannot
+    // be written; a run goes on without it.
+    static bool save(std::string const& input, bool ordered,
+                     tdzdd::Graph const& graph, FrontierManager const& fm) {
+        Header h;
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.magic, magic(), 8);
+        h.version = VERSION;
+        h.flags = ordered ? ORDERED : 0;
+        if (!sourceStamp(input, h.sourceSize, h.sourceTime)) return false;
+
+        const int n = graph.vertexSize();
+        const int m = graph.edgeSize();
+        h.vertices = n;
+        h.edges = m;
+
+        std::string names;
+        for (int v = 1; v <= n; ++v) {
+            names += graph.vertexName(v);
+            names += '\0';
+        }
+        h.nameBytes = names.size();
+
+        std::vector<tdzdd::Graph::EdgeInfo> edgeInfo;
+        std::vector<uint8_t> reversed(m);
+        edgeInfo.reserve(m);
+        for (int a = 0; a < m; ++a) {
+            tdzdd::Graph::EdgeInfo const& e = graph.edgeInfo(a);
+            edgeInfo.push_back(e);
+            reversed[a] = graph.edgeName(a).first != graph.vertexName(e.v1);
+        }
+        h.edgeInfoSize = sizeof(tdzdd::Graph::EdgeInfo);
+
+        std::vector<int32_t> adjOffset(n + 2, 0);
+        std::vector<int32_t> adjVertex;
+        std::vector<int32_t> adjEdge;
+        for (int v = 1; v <= n; ++v) {
+            tdzdd::Graph::NeighborSpan nb = graph.neighbors(v);
+            for (size_t k = 0; k < nb.size(); ++k) {
+                adjVertex.push_back(nb[k]);
+                adjEdge.push_back(nb.edge(k));
+            }
+            adjOffset[v + 1] = adjVertex.size();
+        }
+        h.adjacencySize = adjVertex.size();
+        for (int i = 0; i < m; ++i) {
+            h.enteringSize += fm.getEnteringVs(i).size();
+            h.leavingSize += fm.getLeavingVs(i).size();
+        }
+
+        tdzdd::Graph::BlockDecomposition blocks = graph.decomposeBlocks();
+        h.numBlocks = blocks.numBlocks;
+        std::vector<uint8_t> isBridge(blocks.isBridge.begin(),
+                                      blocks.isBridge.end());
+        std::vector<uint8_t> isArticulation(blocks.isArticulation.begin(),
+                                            blocks.isArticulation.end());
+
+        tdzdd::MessageHandler mh;
+        std::string const file = path(input);
+        std::string const temp = file + ".tmp";
+        mh.begin("writing");
+        mh << " \"" << file << "\" ...";
+        {
+            std::ofstream os(temp.c_str(), std::ios::out | std::ios::binary);
+            if (os) {
+                put(os, &h, 1);
+                put(os, names.data(), names.size());
+                put(os, edgeInfo.data(), edgeInfo.size());
+                put(os, reversed.data(), reversed.size());
+                put(os, adjOffset.data(), adjOffset.size());
+                put(os, adjVertex.data(), adjVertex.size());
+                put(os, adjEdge.data(), adjEdge.size());
+                putTable(os, fm, m, true);
+                putTable(os, fm, m, false);
+                put(os, blocks.blockOf.data(), blocks.blockOf.size());
+                put(os, isBridge.data(), isBridge.size());
+                put(os, isArticulation.data(), isArticulation.size());
+            }
+            if (!os || !os.flush()) {
+                os.close();
+                std::remove(temp.c_str());
+                mh.end("failed");
+                return false;
+            }
+        }
+        if (std::rename(temp.c_str(), file.c_str()) != 0) {
+            std::remove(temp.c_str());
+            mh.end("failed");
+            return false;
+        }
+        mh.end();
+        return true;
+    }
+};
+
+#endif // GRAPH_CACHE_HPP
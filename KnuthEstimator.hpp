@@ -0,0 +1,159 @@
+#ifndef KNUTH_ESTIMATOR_HPP
+#define KNUTH_ESTIMATOR_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Estimate of a number of solutions kept as its base-2 logarithm, so that
+// it does not overflow on graphs of many thousands of edges.
+struct KnuthEstimate {
+    // log2 of the estimate (-infinity for 0)
+    double log2;
+    // standard error relative to the estimate
+    double relativeError;
+    int samples;
+
+    KnuthEstimate()
+        : log2(0), relativeError(0), samples(0) {
+    }
+
+    // Multiplies by an exact count in decimal.
+    void multiply(std::string const& count) {
+        if (count.empty()) return;
+        // the leading digits carry all the precision a double can hold
+        size_t const lead = std::min<size_t>(count.size(), 17);
+        double const head = std::stod(count.substr(0, lead));
+        log2 += std::log2(head) + (count.size() - lead) * std::log2(10.0);
+    }
+
+    // Multiplies by an independent estimate.
+    void multiply(KnuthEstimate const& o) {
+        log2 += o.log2;
+        relativeError = std::sqrt(relativeError * relativeError
+                                  + o.relativeError * o.relativeError);
+    }
+
+    // The estimate in scientific notation, e.g. "1.2346e+67".
+    std::string toString() const {
+        if (std::isinf(log2) && log2 < 0) return "0";
+        double const log10 = log2 * std::log10(2.0);
+        double exponent = std::floor(log10);
+        double mantissa = std::pow(10.0, log10 - exponent);
+        if (mantissa >= 9.99995) {
+            mantissa /= 10;
+            exponent += 1;
+        }
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "%.4fe%+.0f", mantissa, exponent);
+        return buf;
+    }
+};
+
+// Knuth's estimator of the number of paths from the root to the 1-terminal
+// of the diagram of a DD spec, which it never builds. Each sample walks
+// from the root, taking a uniformly random child among the ones that are
+// not the 0-terminal, and weighs the path it ends on by the product of
+// the numbers of children it chose from. The mean weight is an unbiased
+// estimate of the number of paths provided every node other than the
+// 0-terminal reaches the 1-terminal, as in a spec that rejects a partial
+// solution as soon as it cannot be completed (e.g. DagReachSpec: every
+// partial acyclic orientation extends to a whole one). The walks keep one
+// state per child and cost O(levels) each.
+template<typename S>
+class KnuthEstimator {
+    typedef S Spec;
+    typedef uint64_t Word;
+
+    Spec& spec;
+    int const stateWords;
+
+    static int numWords(int n) {
+        return (n + sizeof(Word) - 1) / sizeof(Word);
+    }
+
+    // log2 of the weight of one walk
+    double walk(std::vector<Word>& buf, std::mt19937_64& random) {
+        Word* const cur = buf.data();
+        int i = spec.get_root(cur);
+        double weight = 0;
+        while (i > 0) {
+            int next[Spec::ARITY];
+            int viable = 0;
+            for (int b = 0; b < Spec::ARITY; ++b) {
+                Word* child = cur + (b + 1) * stateWords;
+                spec.get_copy(child, cur);
+                next[b] = spec.get_child(child, i, b);
+                if (next[b] != 0) ++viable;
+            }
+            if (viable == 0) {
+                for (int b = 0; b < Spec::ARITY; ++b) {
+                    spec.destruct(cur + (b + 1) * stateWords);
+                }
+                i = 0;
+                break;
+            }
+            spec.destruct(cur);
+            int pick = std::uniform_int_distribution<int>(0, viable - 1)(random);
+            int chosen = -1;
+            for (int b = 0; b < Spec::ARITY; ++b) {
+                Word* child = cur + (b + 1) * stateWords;
+                if (next[b] != 0 && pick-- == 0) {
+                    spec.get_copy(cur, child);
+                    chosen = b;
+                }
+                spec.destruct(child);
+            }
+            weight += std::log2(double(viable));
+            i = next[chosen];
+        }
+        spec.destruct(cur);
+        return i == 0 ? -std::numeric_limits<double>::infinity() : weight;
+    }
+
+public:
+    KnuthEstimator(Spec& s)
+        : spec(s), stateWords(std::max(1, numWords(spec.datasize()))) {
+    }
+
+    // Averages the weights of samples walks drawn with the given seed.
+    KnuthEstimate estimate(int samples, uint64_t seed = 1) {
+        std::mt19937_64 random(seed);
+        std::vector<Word> buf((Spec::ARITY + 1) * stateWords);
+        std::vector<double> weights(samples);
+        double top = -std::numeric_limits<double>::infinity();
+        for (int s = 0; s < samples; ++s) {
+            weights[s] = walk(buf, random);
+            top = std::max(top, weights[s]);
+        }
+
+        KnuthEstimate e;
+        e.samples = samples;
+        if (samples == 0 || std::isinf(top)) {
+            e.log2 = -std::numeric_limits<double>::infinity();
+            return e;
+        }
+        // moments of the weights scaled by 2^-top
+        double s1 = 0;
+        double s2 = 0;
+        for (int s = 0; s < samples; ++s) {
+            double w = std::exp2(weights[s] - top);
+            s1 += w;
+            s2 += w * w;
+        }
+        double const mean = s1 / samples;
+        e.log2 = top + std::log2(mean);
+        if (samples > 1) {
+            double var = std::max(0.0, (s2 - s1 * mean) / (samples - 1));
+            e.relativeError = std::sqrt(var / samples) / mean;
+        }
+        return e;
+    }
+};
+
+#endif // KNUTH_ESTIMATOR_HPP
@@ -0,0 +1,159 @@
+#ifndef THREAD_ARENA_HPP
+#define THREAD_ARENA_HPP
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+
+// Allocator of the small heap blocks owned by DD states, such as the
+// matrix of FrontierAdjData and the nodes of FrontierClosure. Blocks of up
+// to MAX_BYTES are carved from chunks into free lists by size class, one
+// set of lists per thread, so that the threads of DdBuilderMP allocate
+// and free them without taking a lock. A state is often destroyed by
+// another thread than the one that made it; its blocks then join the free
+// lists of the destroying thread. Chunks are kept until the process ends,
+// and a thread that exits hands its free lists over to a shared pool from
+// which the other threads refill theirs. Larger blocks go to operator new.
+class ThreadArena {
+    static size_t const GRAIN = 16;
+    static size_t const MAX_BYTES = 256;
+    static int const CLASSES = MAX_BYTES / GRAIN;
+    static size_t const CHUNK_BYTES = 64 * 1024;
+
+    struct Block {
+        Block* next;
+    };
+
+    // free lists left by the threads that have exited
+    struct Pool {
+        std::mutex mutex;
+        Block* free[CLASSES];
+
+        Pool() {
+            for (int c = 0; c < CLASSES; ++c) {
+                free[c] = 0;
+            }
+        }
+    };
+
+    struct Local {
+        Block* free[CLASSES];
+        // the rest of the current chunk
+        char* chunk;
+        size_t left;
+
+        Local()
+            : chunk(0), left(0) {
+            for (int c = 0; c < CLASSES; ++c) {
+                free[c] = 0;
+            }
+        }
+
+        ~Local() {
+            Pool& p = pool();
+            std::lock_guard<std::mutex> lock(p.mutex);
+            for (int c = 0; c < CLASSES; ++c) {
+                if (free[c] == 0) continue;
+                Block* last = free[c];
+                while (last->next != 0) {
+                    last = last->next;
+                }
+                last->next = p.free[c];
+                p.free[c] = free[c];
+            }
+        }
+    };
+
+    static Pool& pool() {
+        static Pool p;
+        return p;
+    }
+
+    static Local& local() {
+        thread_local Local l;
+        return l;
+    }
+
+    static int sizeClass(size_t bytes) {
+        return (bytes + GRAIN - 1) / GRAIN - 1;
+    }
+
+    static void* refill(Local& l, int c) {
+        {
+            Pool& p = pool();
+            std::lock_guard<std::mutex> lock(p.mutex);
+            if (p.free[c] != 0) {
+                Block* b = p.free[c];
+                l.free[c] = b->next;
+                p.free[c] = 0;
+                return b;
+            }
+        }
+        size_t const bytes = (c + 1) * GRAIN;
+        if (l.left < bytes) {
+            l.chunk = static_cast<char*>(::operator new(CHUNK_BYTES));
+            l.left = CHUNK_BYTES;
+        }
+        void* b = l.chunk;
+        l.chunk += bytes;
+        l.left -= bytes;
+        return b;
+    }
+
+public:
+    static void* allocate(size_t bytes) {
+        if (bytes == 0 || bytes > MAX_BYTES) return ::operator new(bytes);
+        Local& l = local();
+        int const c = sizeClass(bytes);
+        Block* b = l.free[c];
+        if (b == 0) return refill(l, c);
+        l.free[c] = b->next;
+        return b;
+    }
+
+    static void deallocate(void* p, size_t bytes) {
+        if (bytes == 0 || bytes > MAX_BYTES) {
+            ::operator delete(p);
+            return;
+        }
+        Local& l = local();
+        int const c = sizeClass(bytes);
+        Block* b = static_cast<Block*>(p);
+        b->next = l.free[c];
+        l.free[c] = b;
+    }
+};
+
+// Standard allocator on ThreadArena, for the containers inside DD states.
+template<typename T>
+class ThreadArenaAllocator {
+public:
+    typedef T value_type;
+
+    ThreadArenaAllocator() {
+    }
+
+    template<typename U>
+    ThreadArenaAllocator(ThreadArenaAllocator<U> const&) {
+    }
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(ThreadArena::allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n) {
+        ThreadArena::deallocate(p, n * sizeof(T));
+    }
+
+    template<typename U>
+    bool operator==(ThreadArenaAllocator<U> const&) const {
+        return true;
+    }
+
+    template<typename U>
+    bool operator!=(ThreadArenaAllocator<U> const&) const {
+        return false;
+    }
+};
+
+#endif // THREAD_ARENA_HPP
@@ -0,0 +1,218 @@
+#ifndef TUTTE_POLYNOMIAL_HPP
+#define TUTTE_POLYNOMIAL_HPP
+
+#include <algorithm>
+#include <ostream>
+#include <vector>
+
+#include "BigCount.hpp"
+#include "FrontierPartition.hpp"
+#include "tdzdd/DdEval.hpp"
+#include "tdzdd/DdStructure.hpp"
+#include "tdzdd/util/Graph.hpp"
+
+// Tutte polynomial of a graph, held as its rank-nullity table:
+// count(r, k) is the number of edge subsets A with rank r and nullity k,
+// where rank(A) = |V| - (# of components of (V, A)) and
+// nullity(A) = |A| - rank(A). Then
+//   T(x, y) = sum of count(r, k) (x - 1)^(R - r) (y - 1)^k
+// with R the rank of the whole edge set.
+class TuttePolynomial {
+    // number of rows (ranks) and columns (nullities) of the table
+    int ranks_;
+    int nullities_;
+    std::vector<BigCount> count_;
+
+    void resize(int ranks, int nullities) {
+        if (ranks <= ranks_ && nullities <= nullities_) return;
+        ranks = std::max(ranks, ranks_);
+        nullities = std::max(nullities, nullities_);
+        std::vector<BigCount> c(ranks * nullities);
+        for (int r = 0; r < ranks_; ++r) {
+            for (int k = 0; k < nullities_; ++k) {
+                c[r * nullities + k].swap(count_[r * nullities_ + k]);
+            }
+        }
+        count_.swap(c);
+        ranks_ = ranks;
+        nullities_ = nullities;
+    }
+
+    // Returns |a|^0, ..., |a|^n.
+    static std::vector<BigCount> powers(long a, int n) {
+        std::vector<BigCount> p(n + 1);
+        p[0] = BigCount(1);
+        for (int i = 1; i <= n; ++i) {
+            p[i] = p[i - 1];
+            p[i] *= static_cast<uint64_t>(a < 0 ? -a : a);
+        }
+        return p;
+    }
+
+public:
+    TuttePolynomial()
+        : ranks_(0), nullities_(0) {
+    }
+
+    // the table of the empty edge subset alone
+    static TuttePolynomial unit() {
+        TuttePolynomial t;
+        t.resize(1, 1);
+        t.count_[0] = BigCount(1);
+        return t;
+    }
+
+    BigCount const& count(int r, int k) const {
+        assert(0 <= r && r < ranks_ && 0 <= k && k < nullities_);
+        return count_[r * nullities_ + k];
+    }
+
+    // Adds the table of o with every rank raised by dr and every nullity
+    // raised by dk.
+    void addShifted(TuttePolynomial const& o, int dr, int dk) {
+        if (o.ranks_ == 0) return;
+        resize(o.ranks_ + dr, o.nullities_ + dk);
+        for (int r = 0; r < o.ranks_; ++r) {
+            for (int k = 0; k < o.nullities_; ++k) {
+                BigCount const& c = o.count_[r * o.nullities_ + k];
+                if (c.isZero()) continue;
+                count_[(r + dr) * nullities_ + k + dk] += c;
+            }
+        }
+    }
+
+    // the rank of the whole edge set, or -1 for the zero polynomial
+    int rank() const {
+        for (int r = ranks_ - 1; r >= 0; --r) {
+            for (int k = 0; k < nullities_; ++k) {
+                if (!count(r, k).isZero()) return r;
+            }
+        }
+        return -1;
+    }
+
+    // Returns T(x, y) for x, y >= 0, where it is never negative.
+    BigCount evaluate(long x, long y) const {
+        assert(x >= 0 && y >= 0);
+        const int R = rank();
+        if (R < 0) return BigCount();
+        std::vector<BigCount> px = powers(x - 1, R);
+        std::vector<BigCount> py = powers(y - 1, nullities_);
+        BigCount positive, negative;
+        for (int r = 0; r <= R; ++r) {
+            for (int k = 0; k < nullities_; ++k) {
+                if (count(r, k).isZero()) continue;
+                BigCount t = count(r, k);
+                t *= px[R - r];
+                t *= py[k];
+                bool neg = (x == 0 && (R - r) % 2 != 0)
+                        != (y == 0 && k % 2 != 0);
+                (neg ? negative : positive) += t;
+            }
+        }
+        positive -= negative;
+        return positive;
+    }
+
+    // Returns the coefficients of T: coefficients()[i][j] is that of x^i y^j.
+    std::vector<std::vector<BigCount> > coefficients() const {
+        const int R = rank();
+        std::vector<std::vector<BigCount> > t;
+        if (R < 0) return t;
+
+        // binomial coefficients up to the larger exponent
+        const int n = std::max(R, nullities_);
+        std::vector<std::vector<BigCount> > binom(n + 1);
+        for (int a = 0; a <= n; ++a) {
+            binom[a].resize(a + 1);
+            binom[a][0] = binom[a][a] = BigCount(1);
+            for (int b = 1; b < a; ++b) {
+                binom[a][b] = binom[a - 1][b - 1];
+                binom[a][b] += binom[a - 1][b];
+            }
+        }
+
+        // (x - 1)^a (y - 1)^k expanded; terms of either sign are summed apart
+        std::vector<std::vector<BigCount> > pos(R + 1), neg(R + 1);
+        for (int i = 0; i <= R; ++i) {
+            pos[i].resize(nullities_);
+            neg[i].resize(nullities_);
+        }
+        for (int r = 0; r <= R; ++r) {
+            const int a = R - r;
+            for (int k = 0; k < nullities_; ++k) {
+                if (count(r, k).isZero()) continue;
+                for (int i = 0; i <= a; ++i) {
+                    for (int j = 0; j <= k; ++j) {
+                        BigCount c = count(r, k);
+                        c *= binom[a][i];
+                        c *= binom[k][j];
+                        ((a - i + k - j) % 2 == 0 ? pos : neg)[i][j] += c;
+                    }
+                }
+            }
+        }
+        t.resize(R + 1);
+        for (int i = 0; i <= R; ++i) {
+            t[i].resize(nullities_);
+            for (int j = 0; j < nullities_; ++j) {
+                t[i][j] = pos[i][j];
+                t[i][j] -= neg[i][j];
+            }
+        }
+        return t;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os,
+                                    TuttePolynomial const& o) {
+        std::vector<std::vector<BigCount> > t = o.coefficients();
+        bool first = true;
+        for (int i = static_cast<int>(t.size()) - 1; i >= 0; --i) {
+            for (int j = static_cast<int>(t[i].size()) - 1; j >= 0; --j) {
+                if (t[i][j].isZero()) continue;
+                if (!first) os << " + ";
+                first = false;
+                bool one = (t[i][j] == BigCount(1));
+                if (!one || (i == 0 && j == 0)) os << t[i][j];
+                if (i > 0) os << (one ? "" : "*") << "x";
+                if (i > 1) os << "^" << i;
+                if (j > 0) os << (one && i == 0 ? "" : "*") << "y";
+                if (j > 1) os << "^" << j;
+            }
+        }
+        if (first) os << "0";
+        return os;
+    }
+};
+
+// Computes the rank-nullity table of a ZDD of FrontierPartitionSpec
+// from the bottom up. Levels skipped by the ZDD are 0-arcs, which
+// change neither the rank nor the nullity.
+class TuttePolynomialEval
+    : public tdzdd::DdEval<TuttePolynomialEval, TuttePolynomial> {
+public:
+    void evalTerminal(TuttePolynomial& v, int id) const {
+        v = (id == 0) ? TuttePolynomial() : TuttePolynomial::unit();
+    }
+
+    void evalNode(TuttePolynomial& v, int,
+                  tdzdd::DdValues<TuttePolynomial, 3> const& values) const {
+        v = values.get(0);
+        v.addShifted(values.get(1), 1, 0);
+        v.addShifted(values.get(2), 0, 1);
+    }
+};
+
+// Computes the Tutte polynomial of graph in one frontier-based pass,
+// on the frontier tables fm of graph if given, building the diagram on
+// all OpenMP threads if useMP.
+inline TuttePolynomial computeTuttePolynomial(
+        const tdzdd::Graph& graph, FrontierManagerPtr fm = FrontierManagerPtr(),
+        bool useMP = false) {
+    FrontierPartitionSpec spec(graph, fm);
+    tdzdd::DdStructure<3> dd(spec, useMP);
+    dd.zddReduce();
+    return dd.evaluate(TuttePolynomialEval());
+}
+
+#endif // TUTTE_POLYNOMIAL_HPP
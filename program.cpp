@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <string>
 #include <sstream>
@@ -13,6 +15,7 @@
 #include "tdzdd/DdEval.hpp"
 #include "tdzdd/eval/Cardinality.hpp"
 #include "tdzdd/DdStructure.hpp"
+#include "tdzdd/dd/PathCounter.hpp"
 #include "tdzdd/util/Graph.hpp"
 
 using namespace tdzdd;
@@ -30,6 +33,16 @@ using namespace tdzdd;
 #include "EulerOrientation.hpp"
 #include "DagOrientation.hpp"
 #include "DagOp.hpp"
+#include "DagReach.hpp"
+#include "TuttePolynomial.hpp"
+#include "ComponentScheduler.hpp"
+#include "ClosedFormOrientation.hpp"
+#include "ComponentMemo.hpp"
+#include "CountProduct.hpp"
+#include "GraphCache.hpp"
+#include "EdgeOrder.hpp"
+#include "ComponentPlanner.hpp"
+#include "KnuthEstimator.hpp"
 
 #include "EnumSubgraphs.hpp"
 
@@ -55,6 +68,229 @@ void makeGridGraph(tdzdd::Graph& graph, int n) {
     graph.update();
 }
 
+// Puts the edges of graph in the best order of EdgeOrder, reporting it
+// under title if it narrows the frontier.
+void orderEdges(tdzdd::Graph& graph, const std::string& title) {
+    EdgeOrder::Result input = EdgeOrder::input(graph);
+    EdgeOrder::Result best = EdgeOrder::best(graph);
+    if (!(best < input)) return;
+    std::cerr << title << ": " << best.name << " edge order, max frontier "
+              << input.maxWidth << " -> " << best.maxWidth << std::endl;
+    graph = graph.reordered(best.order);
+}
+
+// Counts the acyclic orientations of *graph level by level within the
+// state budget of ComponentPlanner. If the budget runs out before the
+// edges are ordered, they are put in the order of EdgeOrder in reordered,
+// which graph and frontier are then set to, and counted again. If it runs
+// out again, the count is finished without a limit when exact is set and
+// left empty otherwise.
+std::string countWithinBudget(const tdzdd::Graph*& graph, FrontierManagerPtr& frontier,
+                              tdzdd::Graph& reordered, bool ordered, bool exact,
+                              const std::string& title, std::mutex& consoleMutex) {
+    for (;;) {
+        DagReachSpec spec(*graph, frontier);
+        std::string count = countPathsWithin(
+                spec, ComponentPlanner::levelStates(spec.datasize()),
+                ComponentPlanner::COUNT_STATES);
+        if (!count.empty()) return count;
+
+        if (!ordered) {
+            ordered = true;
+            EdgeOrder::Result input = EdgeOrder::input(*graph);
+            EdgeOrder::Result best = EdgeOrder::best(*graph);
+            if (best < input) {
+                {
+                    std::lock_guard<std::mutex> lock(consoleMutex);
+                    std::cerr << title << ": out of states, retrying in "
+                              << best.name << " edge order, max frontier "
+                              << input.maxWidth << " -> " << best.maxWidth
+                              << std::endl;
+                }
+                reordered = graph->reordered(best.order);
+                graph = &reordered;
+                frontier = std::make_shared<const FrontierManager>(reordered);
+                continue;
+            }
+        }
+        if (!exact) return count;
+
+        {
+            std::lock_guard<std::mutex> lock(consoleMutex);
+            std::cerr << title << ": out of states, counting without a limit"
+                      << std::endl;
+        }
+        return countPaths(spec);
+    }
+}
+
+// Counts the acyclic orientations of every component on threads worker
+// threads (all hardware threads if 0), scheduled by ComponentScheduler.
+// A lone component builds its own diagram on all of them instead.
+// ComponentPlanner routes each component to the closed form, the Tutte
+// engine, a ZDD or a level-by-level count within a state budget. A
+// component out of budget is estimated by KnuthEstimator, unless
+// countOnly asks for exact counts; the estimate is stored in
+// componentEstimates while the count is left empty. With showPlan the
+// plan is printed before anything runs. With reorder, the edges of each
+// component are first put in the order of EdgeOrder. componentSizes
+// gets the number of ZDD nodes of each component, that of the diagram of
+// its isomorphism class if the class was solved before, and 0 if no
+// diagram was built. Returns the number of approximated components.
+int countComponentOrientations(const std::vector<tdzdd::Graph>& inputComponents,
+                               bool useTutte, bool countOnly, bool showPlan,
+                               bool reorder, int threads,
+                               std::vector<size_t>& componentSizes,
+                               std::vector<std::string>& componentCounts,
+                               std::vector<KnuthEstimate>& componentEstimates,
+                               std::vector<double>& componentTimes) {
+    std::mutex consoleMutex;
+    // count and ZDD nodes of each isomorphism class
+    ComponentMemo<std::pair<std::string, size_t> > memo;
+
+    std::vector<tdzdd::Graph> orderedComponents;
+    if (reorder) {
+        for (size_t i = 0; i < inputComponents.size(); ++i) {
+            std::ostringstream title;
+            title << "Component " << i;
+            orderedComponents.push_back(inputComponents[i]);
+            orderEdges(orderedComponents.back(), title.str());
+        }
+    }
+    const std::vector<tdzdd::Graph>& components =
+            reorder ? orderedComponents : inputComponents;
+
+    std::vector<ComponentPlanner::Plan> plans(components.size());
+    std::vector<double> costs(components.size());
+    for (size_t i = 0; i < components.size(); ++i) {
+        plans[i] = ComponentPlanner::plan(components[i], useTutte, countOnly);
+        costs[i] = plans[i].cost();
+        if (showPlan) {
+            std::cerr << "Plan for component " << i << ": ";
+            ComponentPlanner::print(std::cerr, plans[i], countOnly);
+            std::cerr << std::endl;
+        }
+    }
+    ComponentScheduler scheduler(costs, threads > 0 ? threads
+                                                    : std::thread::hardware_concurrency());
+    const bool useMP = threads > 1 && components.size() == 1;
+
+    scheduler.run([&](size_t i) {
+        const tdzdd::Graph& componentGraph = components[i];
+        const ComponentPlanner::Plan& plan = plans[i];
+        if (plan.engine == ComponentPlanner::CLOSED_FORM) {
+            componentCounts[i] = plan.count.toString();
+            std::lock_guard<std::mutex> lock(consoleMutex);
+            std::cerr << "Component " << i << " ("
+                      << ClosedFormOrientation::kindName(plan.kind)
+                      << ") has " << componentCounts[i] << " solutions" << std::endl;
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(consoleMutex);
+            std::cerr << "Processing component " << i
+                      << " with " << componentGraph.vertexSize() << " vertices and "
+                      << componentGraph.edgeSize() << " edges ("
+                      << ComponentPlanner::engineName(plan.engine) << ") in thread "
+                      << std::this_thread::get_id() << std::endl;
+        }
+
+        auto t_start = std::chrono::high_resolution_clock::now();
+        // the graph and frontier counted, replaced if the count reorders
+        // the edges
+        const tdzdd::Graph* graph = &componentGraph;
+        FrontierManagerPtr frontier = plan.frontier;
+        tdzdd::Graph reordered;
+        std::ostringstream title;
+        title << "Component " << i;
+        // the level-by-level count and the estimate leave the other
+        // threads of a lone component idle
+        auto oneThread = [&](const char* engine) {
+            if (!useMP) return;
+            std::lock_guard<std::mutex> lock(consoleMutex);
+            std::cerr << title.str() << ": " << engine
+                      << " runs on one thread, --threads ignored" << std::endl;
+        };
+        typedef std::pair<std::string, size_t> Solution;
+        std::function<Solution()> solve = [&]() -> Solution {
+            if (plan.engine == ComponentPlanner::TUTTE) {
+                // acyclic orientations are T(2,0)
+                return Solution(computeTuttePolynomial(componentGraph, plan.frontier, useMP)
+                                        .evaluate(2, 0).toString(), 0);
+            }
+            if (plan.engine == ComponentPlanner::COUNT_ONLY) {
+                // count top-down level by level without keeping the ZDD
+                oneThread("the level-by-level count");
+                return Solution(countWithinBudget(graph, frontier, reordered, reorder,
+                                                  countOnly, title.str(), consoleMutex), 0);
+            }
+            DagReachSpec spec(componentGraph, plan.frontier);
+            DdStructure<2> dd(spec, useMP);
+            dd.zddReduce();
+            return Solution(dd.zddCardinality(), dd.size());
+        };
+        // isomorphic components are solved once
+        std::vector<int> form;
+        Solution solution = CanonicalForm().compute(componentGraph, form)
+                            ? memo.get(form, solve) : solve();
+        componentCounts[i] = solution.first;
+        componentSizes[i] = solution.second;
+
+        if (componentCounts[i].empty()) {
+            // every partial acyclic orientation extends to a whole one,
+            // so random walks on the reachability states are unbiased
+            oneThread("the estimate");
+            ComponentPlanner::Plan walks = plan;
+            walks.engine = ComponentPlanner::APPROXIMATE;
+            walks.maxWidth = frontier->getMaxFrontierSize();
+            DagReachSpec spec(*graph, frontier);
+            componentEstimates[i] = KnuthEstimator<DagReachSpec>(spec)
+                    .estimate(walks.samples());
+        }
+        auto t_end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> elapsed = t_end - t_start;
+        componentTimes[i] = elapsed.count();  // 单位：秒
+
+        std::lock_guard<std::mutex> lock(consoleMutex);
+        if (componentCounts[i].empty()) {
+            std::cerr << "Component " << i << " has about "
+                      << componentEstimates[i].toString() << " solutions (rel. error "
+                      << componentEstimates[i].relativeError << ", "
+                      << componentEstimates[i].samples << " samples)" << std::endl;
+        } else {
+            std::cerr << "Component " << i << " completed with "
+                      << componentCounts[i] << " solutions" << std::endl;
+        }
+    });
+    std::cerr << memo.hits() << " components answered by "
+              << memo.size() << " isomorphism classes" << std::endl;
+    return std::count_if(componentCounts.begin(), componentCounts.end(),
+                         [](const std::string& count) { return count.empty(); });
+}
+
+// Prints the product of the component counts, which is exact unless a
+// component (with an empty count) was only estimated.
+void printCombinedResult(size_t totalSize, const CountProduct& exact,
+                         const std::vector<std::string>& componentCounts,
+                         const std::vector<KnuthEstimate>& componentEstimates) {
+    KnuthEstimate estimate;
+    bool approximate = false;
+    for (size_t i = 0; i < componentCounts.size(); ++i) {
+        if (componentCounts[i].empty()) {
+            estimate.multiply(componentEstimates[i]);
+            approximate = true;
+        }
+    }
+    std::cerr << "Combined result: " << totalSize << " ZDD nodes, ";
+    if (approximate) {
+        estimate.multiply(exact.toString());
+        std::cerr << "about " << estimate.toString() << " total solutions (rel. error "
+                  << estimate.relativeError << ")" << std::endl;
+    } else {
+        std::cerr << exact << " total solutions" << std::endl;
+    }
+}
+
 int main(int argc, char** argv) {
 
     if (argc == 1) {
@@ -67,8 +303,8 @@ int main(int argc, char** argv) {
         for (int n = 2; n <= 10; ++n) {
             tdzdd::Graph graph;
             makeGridGraph(graph, n);
-            FrontierManager fm(graph);
-            FrontierSingleCycleSpec spec(graph);
+            FrontierManagerPtr fm = std::make_shared<const FrontierManager>(graph);
+            FrontierSingleCycleSpec spec(graph, fm);
             DdStructure<2> dd(spec);
             std::cerr << "n = " << n << ", # of solutions = "
                       << dd.zddCardinality();
@@ -101,13 +337,22 @@ int main(int argc, char** argv) {
         bool is_dag = false;
         bool is_dagop = false;
         bool is_dagsimpl = false;
+        bool is_dagreach = false;
         bool is_dagjustbcc = false;
+        bool is_tutte = false;
+        bool is_cache = false;
+        bool is_order = false;
+        bool is_plan = false;
 
         bool is_dot = false;
         bool is_show_fs = false;
         bool is_enum = false;
+        bool is_count_only = false;
+        // 0: 每个模式的默认线程数
+        int num_threads = 0;
 
         bool readfirst = false;
+        std::string filename;
         for (int i = 1; i < argc; ++i) {
             if (std::string(argv[i]) == std::string("--path")) {
                 is_path = true;
@@ -149,6 +394,8 @@ int main(int argc, char** argv) {
                 is_show_fs = true;
             } else if (std::string(argv[i]) == std::string("--enum")) {
                 is_enum = true;
+            } else if (std::string(argv[i]) == std::string("--count-only")) {
+                is_count_only = true;
             } else if (std::string(argv[i]) == std::string("--my-spec")) {
                 is_my = true;
             } else if (std::string(argv[i]) == std::string("--euler")) {
@@ -163,110 +410,181 @@ int main(int argc, char** argv) {
             else if (std::string(argv[i]) == std::string("--dagsimpl")) {
                 is_dagsimpl = true;
             }
+            else if (std::string(argv[i]) == std::string("--dagreach")) {
+                is_dagreach = true;
+            }
             else if (std::string(argv[i]) == std::string("--dagjust")) {
                 is_dagjustbcc = true;
             }
+            else if (std::string(argv[i]) == std::string("--tutte")) {
+                is_tutte = true;
+            }
+            else if (std::string(argv[i]) == std::string("--cache")) {
+                is_cache = true;
+            }
+            else if (std::string(argv[i]) == std::string("--order")) {
+                is_order = true;
+            }
+            else if (std::string(argv[i]) == std::string("--plan")) {
+                is_plan = true;
+            }
+            else if (std::string(argv[i]) == std::string("--threads")) {
+                if (i + 1 >= argc || std::atoi(argv[i + 1]) < 1) {
+                    std::cerr << "--threads needs a positive number" << std::endl;
+                    return 1;
+                }
+                num_threads = std::atoi(argv[++i]);
+            }
             else if (argv[i][0] == '-') {
                 std::cerr << "unknown option " << argv[i] << std::endl;
                 return 1;
             } else {
                 if (!readfirst) {
                     readfirst = true;
-                    graph.readEdges(argv[i]);
+                    filename = argv[i];
                 } else {
                     std::cerr << "illegal argument " << argv[i] << std::endl;
                     return 1;
                 }
             }
         }
+        // 有有效缓存时直接载入图(含选定的边序)、前沿表和块分解，
+        // 否则读入文本后写出缓存
+        std::vector<std::vector<int> > enteringVss, leavingVss;
+        bool cached = is_cache &&
+                      GraphCache::load(filename, is_order, graph, enteringVss, leavingVss);
+        if (readfirst && !cached) {
+            if (filename.size() >= 4 &&
+                filename.compare(filename.size() - 4, 4, ".mtx") == 0) {
+                graph.readMatrixMarket(filename);
+            } else {
+                graph.readEdges(filename);
+            }
+            if (is_order) {
+                orderEdges(graph, "Graph");
+            }
+        }
+#ifdef _OPENMP
+        if (num_threads > 0) {
+            omp_set_num_threads(num_threads);
+        }
+#endif
+        // 多于一个线程时逐层并行构建 ZDD
+        const bool use_mp = num_threads > 1;
         //use tarjan algorithm here to decompose to graph
-        FrontierManager fm(graph);
+        // 前沿表只构建一次，由下面的 spec 共享
+        FrontierManagerPtr fm = cached
+                ? std::make_shared<const FrontierManager>(graph, enteringVss, leavingVss)
+                : std::make_shared<const FrontierManager>(graph);
+        if (is_cache && readfirst && !cached) {
+            GraphCache::save(filename, is_order, graph, *fm);
+        }
 
         std::cerr << "# of vertices = " << graph.vertexSize() << std::endl;
         std::cerr << "# of edges = " << graph.edgeSize() << std::endl;
 
         if (is_show_fs) {
-            fm.print();
+            fm->print();
         }
 
         DdStructure<2> dd;
 
-        std::ostringstream oss;
-        oss << graph.vertexSize();
-        const int endPoint = graph.getVertex(oss.str());
+        // s-t paths end at the vertex named n; other kinds do not need it,
+        // so inputs numbered from 0 are accepted for them
+        int endPoint = 0;
+        if (is_path || is_ham_path || is_path_m || is_ham_path_m) {
+            std::ostringstream oss;
+            oss << graph.vertexSize();
+            endPoint = graph.getVertex(oss.str());
+        }
 
         if (is_path) {
-            FrontierSTPathSpec spec(graph, false, graph.getVertex("1"), endPoint);
-            dd = DdStructure<2>(spec);
+            FrontierSTPathSpec spec(graph, false, graph.getVertex("1"), endPoint, fm);
+            dd = DdStructure<2>(spec, use_mp);
         } else if (is_ham_path) {
-            FrontierSTPathSpec spec(graph, true, graph.getVertex("1"), endPoint);
-            dd = DdStructure<2>(spec);
+            FrontierSTPathSpec spec(graph, true, graph.getVertex("1"), endPoint, fm);
+            dd = DdStructure<2>(spec, use_mp);
         } else if (is_cycle) {
-            FrontierSingleCycleSpec spec(graph);
-            dd = DdStructure<2>(spec);
+            FrontierSingleCycleSpec spec(graph, fm);
+            dd = DdStructure<2>(spec, use_mp);
         } else if (is_ham_cycle) {
-            FrontierSingleHamiltonianCycleSpec spec(graph);
-            dd = DdStructure<2>(spec);
+            FrontierSingleHamiltonianCycleSpec spec(graph, fm);
+            dd = DdStructure<2>(spec, use_mp);
         } else if (is_path_m) {
-            FrontierMateSpec spec(graph, false, graph.getVertex("1"), endPoint);
-            dd = DdStructure<2>(spec);
+            FrontierMateSpec spec(graph, false, graph.getVertex("1"), endPoint, fm);
+            dd = DdStructure<2>(spec, use_mp);
         } else if (is_ham_path_m) {
-            FrontierMateSpec spec(graph, true, graph.getVertex("1"), endPoint);
-            dd = DdStructure<2>(spec);
+            FrontierMateSpec spec(graph, true, graph.getVertex("1"), endPoint, fm);
+            dd = DdStructure<2>(spec, use_mp);
         } else if (is_cycle_m) {
-            FrontierMateSpec spec(graph, false);
-            dd = DdStructure<2>(spec);
+            FrontierMateSpec spec(graph, false, fm);
+            dd = DdStructure<2>(spec, use_mp);
         } else if (is_ham_cycle_m) {
-            FrontierMateSpec spec(graph, true);
-            dd = DdStructure<2>(spec);
+            FrontierMateSpec spec(graph, true, fm);
+            dd = DdStructure<2>(spec, use_mp);
         } else if (is_forest) {
-            FrontierForestSpec spec(graph);
-            dd = DdStructure<2>(spec);
+            FrontierForestSpec spec(graph, fm);
+            dd = DdStructure<2>(spec, use_mp);
         } else if (is_tree) {
-            FrontierTreeSpec spec(graph, false);
-            dd = DdStructure<2>(spec);
+            FrontierTreeSpec spec(graph, false, fm);
+            dd = DdStructure<2>(spec, use_mp);
         } else if (is_stree) {
-            FrontierTreeSpec spec(graph, true);
-            dd = DdStructure<2>(spec);
+            FrontierTreeSpec spec(graph, true, fm);
+            dd = DdStructure<2>(spec, use_mp);
         } else if (is_matching) {
-            FrontierMatchingSpec spec(graph, false);
-            dd = DdStructure<2>(spec);
+            FrontierMatchingSpec spec(graph, false, fm);
+            dd = DdStructure<2>(spec, use_mp);
         } else if (is_cmatching) {
-            FrontierMatchingSpec spec(graph, true);
-            dd = DdStructure<2>(spec);
+            FrontierMatchingSpec spec(graph, true, fm);
+            dd = DdStructure<2>(spec, use_mp);
         } else if (is_letter_I) {
             std::vector<IntSubset*> degRanges;
             degRanges.push_back(new IntRange(0, INT_MAX));
             degRanges.push_back(new IntRange(2, 2));
             degRanges.push_back(new IntRange(0, INT_MAX));
-            FrontierDegreeDistributionSpec spec(graph, degRanges, true);
-            dd = DdStructure<2>(spec);
+            FrontierDegreeDistributionSpec spec(graph, degRanges, true, fm);
+            dd = DdStructure<2>(spec, use_mp);
         } else if (is_letter_P) {
             std::vector<IntSubset*> degRanges;
             degRanges.push_back(new IntRange(0, INT_MAX));
             degRanges.push_back(new IntRange(1, 1));
             degRanges.push_back(new IntRange(0, INT_MAX));
             degRanges.push_back(new IntRange(1, 1));
-            FrontierDegreeDistributionSpec spec(graph, degRanges, true);
-            dd = DdStructure<2>(spec);
+            FrontierDegreeDistributionSpec spec(graph, degRanges, true, fm);
+            dd = DdStructure<2>(spec, use_mp);
         } else if (is_my) {
             Combination spec(5, 2);
             spec.dumpDot(std::cout);
         } else if (is_euler) {
-            EulerOrientationSpec spec(graph);
-            dd = DdStructure<2>(spec);
+            EulerOrientationSpec spec(graph, fm);
+            dd = DdStructure<2>(spec, use_mp);
         }
         else if (is_dag) {
-            DagOrientationSpec spec(graph);
-            dd = DdStructure<2>(spec);
+            DagOrientationSpec spec(graph, fm);
+            dd = DdStructure<2>(spec, use_mp);
             dd.zddReduce();
+            std::cerr << "There are " << dd.zddCardinality() << " Solutions." << std::endl;
         }
         else if (is_dagsimpl) {
-            DagOpSpec spec(graph);
-            dd = DdStructure<2>(spec);
+            DagOpSpec spec(graph, fm);
+            dd = DdStructure<2>(spec, use_mp);
             dd.zddReduce();
             std::cerr << "There are " << dd.zddCardinality() << " Solutions." << std::endl;
         }
+        else if (is_dagreach) {
+            DagReachSpec spec(graph, fm);
+            if (is_count_only) {
+                if (use_mp) {
+                    std::cerr << "The level-by-level count runs on one thread, "
+                              << "--threads ignored" << std::endl;
+                }
+                std::cerr << "There are " << countPaths(spec) << " Solutions." << std::endl;
+            } else {
+                dd = DdStructure<2>(spec, use_mp);
+                dd.zddReduce();
+                std::cerr << "There are " << dd.zddCardinality() << " Solutions." << std::endl;
+            }
+        }
         else if (is_dagop) {
             // 分解图为连通分量
             std::vector<tdzdd::Graph> components = graph.decomposeToBCCAndBridges1();
@@ -279,95 +597,44 @@ int main(int argc, char** argv) {
 //                dd = DdStructure<2>(spec);
 //                dd.zddReduce();
 //            } else {
-                // 多个连通分量，使用受控的多线程处理
-                const size_t maxThreads = std::min(components.size(),
-                                                   static_cast<size_t>(std::thread::hardware_concurrency()));
-
-                std::vector<DdStructure<2> > componentDDs(components.size());
-                std::vector<std::thread> threads;
-                std::mutex consoleMutex;
+                std::vector<size_t> componentSizes(components.size());
+                std::vector<std::string> componentCounts(components.size());
+                std::vector<KnuthEstimate> componentEstimates(components.size());
                 std::vector<double> componentTimes(components.size());
-                int skipped = 0;
-                // 使用 std::function 包装 lambda
-                std::function<void(size_t, size_t)> processComponent = [&](size_t startIdx, size_t endIdx) {
-                    for (size_t i = startIdx; i < endIdx; ++i) {
-                        const tdzdd::Graph& componentGraph = components[i];
-                        if (componentGraph.edgeSize() > 25) {
-                            {
-                                std::lock_guard<std::mutex> lock(consoleMutex);
-                                skipped += 1;
-//                                std::cerr << "Skipping component " << i
-//                                          << " with " << componentGraph.edgeSize()
-//                                          << " edges (exceeds 25)" << std::endl;
-                            }
-                            continue;  // 跳过这个 component
-                        }
-                        {
-                            std::lock_guard<std::mutex> lock(consoleMutex);
-                            std::cerr << "Processing component " << i
-                                      << " with " << componentGraph.vertexSize() << " vertices and "
-                                      << componentGraph.edgeSize() << " edges in thread "
-                                      << std::this_thread::get_id() << std::endl;
-                        }
-
-                        DagOpSpec spec(componentGraph);
-                        auto t_start = std::chrono::high_resolution_clock::now();
-                        componentDDs[i] = DdStructure<2>(spec);
-                        componentDDs[i].zddReduce();
-                        auto t_end = std::chrono::high_resolution_clock::now();
-                        std::chrono::duration<double> elapsed = t_end - t_start;
-                        componentTimes[i] = elapsed.count();  // 单位：秒
-
-                        {
-                            std::lock_guard<std::mutex> lock(consoleMutex);
-                            std::cerr << "Component " << i << " completed with "
-                                      << componentDDs[i].zddCardinality() << " solutions" << std::endl;
-                        }
-                    }
-                };
-
-                // 分配工作给线程
-                size_t componentsPerThread = (components.size() + maxThreads - 1) / maxThreads;
-
-                for (size_t t = 0; t < maxThreads; ++t) {
-                    size_t startIdx = t * componentsPerThread;
-                    size_t endIdx = std::min(startIdx + componentsPerThread, components.size());
-
-                    if (startIdx < components.size()) {
-                        threads.emplace_back(processComponent, startIdx, endIdx);
-                    }
-                }
 
-                // 等待所有线程完成
                 auto t_start = std::chrono::high_resolution_clock::now();
-                for (auto& thread : threads) {
-                    thread.join();
-                }
+                int approximated = countComponentOrientations(components, is_tutte, is_count_only,
+                                                              is_plan, is_order, num_threads,
+                                                              componentSizes,
+                                                              componentCounts, componentEstimates,
+                                                              componentTimes);
                 auto t_end = std::chrono::high_resolution_clock::now();
                 std::chrono::duration<double> elapsed = t_end - t_start;
 
                 std::cerr << "All components processed. Combining results..." << std::endl;
                 size_t total_size = 0;
-                unsigned long long total_solutions = 1;
+                CountProduct total_solutions;
                 // 合并结果
-                if (!componentDDs.empty()) {
-                    for (size_t i = 0; i < componentDDs.size(); ++i) {
-                        std::cerr << "Combining component " << i << " result..." << std::endl;
-                        std::cerr << "size of " <<  i  << " = " << componentDDs[i].size() << " ZDD nodes, "
-                                  << "solution of " <<  i  << " = " << std::stoull(componentDDs[i].zddCardinality()) << " total solutions" << std::endl;
-                        // 根据实际需要实现合并逻辑
-                        total_size += componentDDs[i].size();
-                        total_solutions *= (std::stoull(componentDDs[i].zddCardinality()) == 0) ? 1: std::stoull(componentDDs[i].zddCardinality());
-//                        total_solutions %= MOD;
+                for (size_t i = 0; i < componentSizes.size(); ++i) {
+                    std::cerr << "size of " <<  i  << " = " << componentSizes[i] << " ZDD nodes, "
+                              << "solution of " <<  i  << " = "
+                              << (componentCounts[i].empty()
+                                  ? "~" + componentEstimates[i].toString() + " (approximate)"
+                                  : componentCounts[i]) << std::endl;
+                    total_size += componentSizes[i];
+                    if (!componentCounts[i].empty()) {
+                        total_solutions.multiply(componentCounts[i]);
                     }
                 }
 
-                std::cerr << "Combined result: " << total_size << " ZDD nodes, "
-                          << total_solutions << " total solutions" << std::endl;
-                double maxTime = *std::max_element(componentTimes.begin(), componentTimes.end());
-                std::cerr << "Max component processing time: " << maxTime << " sec" << std::endl;
+                printCombinedResult(total_size, total_solutions, componentCounts,
+                                    componentEstimates);
+                if (!componentTimes.empty()) {
+                    double maxTime = *std::max_element(componentTimes.begin(), componentTimes.end());
+                    std::cerr << "Max component processing time: " << maxTime << " sec" << std::endl;
+                }
                 std::cerr << "Total processing time: " << elapsed.count() << " sec" << std::endl;
-                std::cerr << "Skipped " << skipped << " bccs" << std::endl;
+                std::cerr << "Approximated " << approximated << " bccs" << std::endl;
 //            }
         }
         else if (is_dagjustbcc) {
@@ -378,103 +645,65 @@ int main(int argc, char** argv) {
             if(components.empty()){
                 int tree_sz = forest.edgeSize();
                 std::cerr << "Edge Size of BridgeTree:  " << tree_sz << std::endl;
+                CountProduct total_solutions;
+                total_solutions.multiplyPowerOfTwo(tree_sz);
                 std::cerr << "Combined result: " << 0 << " ZDD nodes, "
-                          << std::pow(2, tree_sz)<< " total solutions" << std::endl;
+                          << total_solutions << " total solutions" << std::endl;
                 return 0;
             }
             std::cerr << "Graph decomposed into " << components.size() << " connected components." << std::endl;
 
-            // 多个连通分量，使用受控的多线程处理
-            const size_t maxThreads = std::min(components.size(),
-                                               static_cast<size_t>(std::thread::hardware_concurrency()));
-
-            std::vector<DdStructure<2> > componentDDs(components.size());
-            std::vector<std::thread> threads;
-            std::mutex consoleMutex;
-
+            std::vector<size_t> componentSizes(components.size());
+            std::vector<std::string> componentCounts(components.size());
+            std::vector<KnuthEstimate> componentEstimates(components.size());
             std::vector<double> componentTimes(components.size());
-            int skipped = 0;
-            // 使用 std::function 包装 lambda
-            std::function<void(size_t, size_t)> processComponent = [&](size_t startIdx, size_t endIdx) {
-                for (size_t i = startIdx; i < endIdx; ++i) {
-                    const tdzdd::Graph& componentGraph = components[i];
-                    if (componentGraph.edgeSize() > 25) {
-                        {
-                            std::lock_guard<std::mutex> lock(consoleMutex);
-                            skipped++;
-                            std::cerr << "Skipping component " << i
-                                      << " with " << componentGraph.edgeSize()
-                                      << " edges (exceeds 25)" << std::endl;
-                        }
-                        continue;  // 跳过这个 component
-                    }
-                    {
-                        std::lock_guard<std::mutex> lock(consoleMutex);
-                        std::cerr << "Processing component " << i
-                                  << " with " << componentGraph.vertexSize() << " vertices and "
-                                  << componentGraph.edgeSize() << " edges in thread "
-                                  << std::this_thread::get_id() << std::endl;
-                    }
 
-                    DagOpSpec spec(componentGraph);
-                    auto t_start = std::chrono::high_resolution_clock::now();
-                    componentDDs[i] = DdStructure<2>(spec);
-                    componentDDs[i].zddReduce();
-                    auto t_end = std::chrono::high_resolution_clock::now();
-                    std::chrono::duration<double> elapsed = t_end - t_start;
-                    componentTimes[i] = elapsed.count();  // 单位：秒
-                    {
-                        std::lock_guard<std::mutex> lock(consoleMutex);
-                        std::cerr << "Component " << i << " completed with "
-                                  << componentDDs[i].zddCardinality() << " solutions" << std::endl;
-                    }
-                }
-            };
-
-            // 分配工作给线程
-            size_t componentsPerThread = (components.size() + maxThreads - 1) / maxThreads;
-
-            for (size_t t = 0; t < maxThreads; ++t) {
-                size_t startIdx = t * componentsPerThread;
-                size_t endIdx = std::min(startIdx + componentsPerThread, components.size());
-
-                if (startIdx < components.size()) {
-                    threads.emplace_back(processComponent, startIdx, endIdx);
-                }
-            }
-
-            // 等待所有线程完成
             auto t_start = std::chrono::high_resolution_clock::now();
-            for (auto& thread : threads) {
-                thread.join();
-            }
+            int approximated = countComponentOrientations(components, is_tutte, is_count_only,
+                                                          is_plan, is_order, num_threads,
+                                                          componentSizes,
+                                                          componentCounts, componentEstimates,
+                                                          componentTimes);
             auto t_end = std::chrono::high_resolution_clock::now();
             std::chrono::duration<double> elapsed = t_end - t_start;
 
             std::cerr << "All components processed. Combining results..." << std::endl;
             size_t total_size = 0;
-            double total_solutions = 1;
+            CountProduct total_solutions;
             // 合并结果
-            if (!componentDDs.empty()) {
-                for (size_t i = 0; i < componentDDs.size(); ++i) {
-                    double card = std::stod(componentDDs[i].zddCardinality());
-                    std::cerr << "Combining component " << i << " result..." << std::endl;
-                    std::cerr << "size of " <<  i  << " = " << componentDDs[i].size() << " ZDD nodes, "
-                              << "solution of " <<  i  << " = " << card << " total solutions" << std::endl;
-                    // 根据实际需要实现合并逻辑
-                    total_size += componentDDs[i].size();
-                    // 为什么会有为0的zdd啊
-                    total_solutions *= (card < 0.1) ? 1: card;
+            for (size_t i = 0; i < componentSizes.size(); ++i) {
+                std::cerr << "size of " <<  i  << " = " << componentSizes[i] << " ZDD nodes, "
+                          << "solution of " <<  i  << " = "
+                          << (componentCounts[i].empty()
+                              ? "~" + componentEstimates[i].toString() + " (approximate)"
+                              : componentCounts[i]) << std::endl;
+                total_size += componentSizes[i];
+                if (!componentCounts[i].empty()) {
+                    total_solutions.multiply(componentCounts[i]);
                 }
-                double maxTime = *std::max_element(componentTimes.begin(), componentTimes.end());
-                std::cerr << "Max component processing time: " << maxTime << " sec" << std::endl;
             }
+            double maxTime = *std::max_element(componentTimes.begin(), componentTimes.end());
+            std::cerr << "Max component processing time: " << maxTime << " sec" << std::endl;
+            // every bridge may be oriented either way
             int tree_sz = forest.edgeSize();
+            total_solutions.multiplyPowerOfTwo(tree_sz);
             std::cerr << "Edge Size of BridgeTree:  " << tree_sz << std::endl;
-            std::cerr << "Combined result: " << total_size << " ZDD nodes, "
-                      << total_solutions * std::pow(2, tree_sz)<< " total solutions" << std::endl;
+            printCombinedResult(total_size, total_solutions, componentCounts,
+                                componentEstimates);
             std::cerr << "Total processing time: " << elapsed.count() << " sec" << std::endl;
-            std::cerr << "Skipped " << skipped << " bccs" << std::endl;
+            std::cerr << "Approximated " << approximated << " bccs" << std::endl;
+        }
+        else if (is_tutte) {
+            TuttePolynomial tutte = computeTuttePolynomial(graph, fm, use_mp);
+            std::cout << "T(x,y) = " << tutte << std::endl;
+            std::cerr << "T(2,0) = " << tutte.evaluate(2, 0)
+                      << " acyclic orientations" << std::endl;
+            std::cerr << "T(0,2) = " << tutte.evaluate(0, 2)
+                      << " totally cyclic orientations" << std::endl;
+            std::cerr << "T(1,1) = " << tutte.evaluate(1, 1)
+                      << " spanning trees (maximal spanning forests)" << std::endl;
+            std::cerr << "T(2,1) = " << tutte.evaluate(2, 1)
+                      << " forests" << std::endl;
         }
         else {
             std::cerr << "Please specify a kind of subgraphs." << std::endl;
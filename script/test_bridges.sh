@@ -0,0 +1,17 @@
+#!/bin/bash
+
+# --dagop 与 --dagjust 在含桥边的图上必须给出相同的计数
+cd "$(dirname "$0")"
+
+status=0
+for graph in tree.txt path.txt SW-100-3-0d1-trial1.edges SW-1000-3-0d1-trial1.edges power-494-bus.mtx; do
+    op=$(../program --dagop ../dataset/dag/$graph 2>&1 | grep -a "total solutions" | sed 's/.*ZDD nodes, //')
+    just=$(../program --dagjust ../dataset/dag/$graph 2>&1 | grep -a "total solutions" | sed 's/.*ZDD nodes, //')
+    if [ -z "$op" ] || [ "$op" != "$just" ]; then
+        echo "$graph: --dagop gives '$op' but --dagjust gives '$just'"
+        status=1
+    else
+        echo "$graph: ok"
+    fi
+done
+exit $status
@@ -27,6 +27,7 @@
 #include <cassert>
 #include <iostream>
 #include <stdexcept>
+#include <vector>
 
 #include "dd/DdBuilder.hpp"
 #include "dd/DepthFirstSearcher.hpp"
@@ -52,6 +53,8 @@ namespace tdzdd {
  *
  * Optionally, the following functions can be overloaded:
  * - void printLevel(std::ostream& os, int level) const
+ * - int datasize_at(int level) const
+ * - void get_copy_at(void* to, void const* from, int level)
  *
  * A return code of get_root(void*) or get_child(void*, int, bool) is:
  * 0 when the node is the 0-terminal, -1 when it is the 1-terminal, or
@@ -81,6 +84,27 @@ public:
         os << level;
     }
 
+    /**
+     * Returns the number of bytes a state at the given level uses,
+     * which is all of datasize() unless the spec says otherwise.
+     * DdBuilder sizes the nodes of each level by it.
+     * @param level the level.
+     */
+    int datasize_at(int level) const {
+        return entity().datasize();
+    }
+
+    /**
+     * Copies a state at the given level, which needs only the first
+     * datasize_at(level) bytes of the destination.
+     * @param to the destination.
+     * @param from the source.
+     * @param level the level.
+     */
+    void get_copy_at(void* to, void const* from, int level) {
+        entity().get_copy(to, from);
+    }
+
     /**
      * Returns a random instance using simple depth-first search
      * without caching.
@@ -351,6 +375,12 @@ public:
  * Abstract class of DD specifications using POD array states.
  * The size of array must be set by setArraySize(int n) in the constructor
  * and cannot be changed.
+ * A spec whose states use only a prefix of the array at some levels can
+ * also declare that prefix by setArraySizeAtLevel(sizes) in the
+ * constructor. DdBuilder then allocates the nodes of each level at that
+ * size, and states are copied, hashed and compared over that prefix only;
+ * getChild still receives a whole array, of which the elements beyond the
+ * prefix of the level are undefined.
  * If you want some arbitrary-sized data storage for states,
  * use pointers to those storages in DdSpec instead.
  *
@@ -379,6 +409,8 @@ private:
 
     int arraySize;
     int dataWords;
+    // levelWords[i]: words of a state at level i (empty if all dataWords)
+    std::vector<int> levelWords;
 
     static State* state(void* p) {
         return static_cast<State*>(p);
@@ -388,6 +420,32 @@ private:
         return static_cast<State const*>(p);
     }
 
+    int wordsAt(int level) const {
+        return (0 <= level && level < int(levelWords.size())) ?
+                levelWords[level] : dataWords;
+    }
+
+    static size_t hashWords(State const* s, int words) {
+        Word const* pa = reinterpret_cast<Word const*>(s);
+        Word const* pz = pa + words;
+        size_t h = 0;
+        while (pa != pz) {
+            h += *pa++;
+            h *= 314159257;
+        }
+        return h;
+    }
+
+    static bool equalWords(State const* s1, State const* s2, int words) {
+        Word const* pa = reinterpret_cast<Word const*>(s1);
+        Word const* qa = reinterpret_cast<Word const*>(s2);
+        Word const* pz = pa + words;
+        while (pa != pz) {
+            if (*pa++ != *qa++) return false;
+        }
+        return true;
+    }
+
 protected:
     void setArraySize(int n) {
         assert(0 <= n);
@@ -398,6 +456,24 @@ protected:
         dataWords = (n * sizeof(State) + sizeof(Word) - 1) / sizeof(Word);
     }
 
+    /**
+     * Declares that a state at level i uses only its first sizes[i]
+     * elements, none of which may exceed the array size. Levels beyond
+     * sizes use the whole array.
+     * @param sizes array sizes indexed by level.
+     */
+    void setArraySizeAtLevel(std::vector<int> const& sizes) {
+        if (arraySize < 0)
+            throw std::runtime_error(
+                    "Array size is unknown; please set it by setArraySize(int) before setArraySizeAtLevel.");
+        levelWords.resize(sizes.size());
+        for (size_t i = 0; i < sizes.size(); ++i) {
+            assert(0 <= sizes[i] && sizes[i] <= arraySize);
+            levelWords[i] = (sizes[i] * sizeof(State) + sizeof(Word) - 1)
+                    / sizeof(Word);
+        }
+    }
+
     int getArraySize() const {
         return arraySize;
     }
@@ -414,6 +490,11 @@ public:
         return dataWords * sizeof(Word);
     }
 
+    int datasize_at(int level) const {
+        if (dataWords < 0) return datasize();
+        return wordsAt(level) * sizeof(Word);
+    }
+
     int get_root(void* p) {
         return this->entity().getRoot(state(p));
     }
@@ -432,6 +513,15 @@ public:
         }
     }
 
+    void get_copy_at(void* to, void const* from, int level) {
+        Word const* pa = static_cast<Word const*>(from);
+        Word const* pz = pa + wordsAt(level);
+        Word* qa = static_cast<Word*>(to);
+        while (pa != pz) {
+            *qa++ = *pa++;
+        }
+    }
+
     int mergeStates(T* a1, T* a2) {
         return 0;
     }
@@ -447,17 +537,11 @@ public:
     }
 
     size_t hashCode(State const* s) const {
-        Word const* pa = reinterpret_cast<Word const*>(s);
-        Word const* pz = pa + dataWords;
-        size_t h = 0;
-        while (pa != pz) {
-            h += *pa++;
-            h *= 314159257;
-        }
-        return h;
+        return hashWords(s, dataWords);
     }
 
     size_t hashCodeAtLevel(State const* s, int level) const {
+        if (!levelWords.empty()) return hashWords(s, wordsAt(level));
         return this->entity().hashCode(s);
     }
 
@@ -466,16 +550,11 @@ public:
     }
 
     bool equalTo(State const* s1, State const* s2) const {
-        Word const* pa = reinterpret_cast<Word const*>(s1);
-        Word const* qa = reinterpret_cast<Word const*>(s2);
-        Word const* pz = pa + dataWords;
-        while (pa != pz) {
-            if (*pa++ != *qa++) return false;
-        }
-        return true;
+        return equalWords(s1, s2, dataWords);
     }
 
     bool equalToAtLevel(State const* s1, State const* s2, int level) const {
+        if (!levelWords.empty()) return equalWords(s1, s2, wordsAt(level));
         return this->entity().equalTo(s1, s2);
     }
 
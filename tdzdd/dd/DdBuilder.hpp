@@ -28,6 +28,7 @@
 #include <cmath>
 #include <ostream>
 #include <stdexcept>
+#include <thread>
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -107,32 +108,43 @@ protected:
 
 class DdBuilderMPBase {
 protected:
-    static int const headerSize = 2;
+    static int const headerSize = 3;
 
     /* SpecNode
-     * ┌────────┬────────┬────────┬────────┬─────
-     * │ srcPtr │ nodeId │state[0]│state[1]│ ...
-     * └────────┴────────┴────────┴────────┴─────
+     * ┌────────┬────────┬────────┬────────┬────────┬─────
+     * │  code  │  hash  │ column │state[0]│state[1]│ ...
+     * └────────┴────────┴────────┴────────┴────────┴─────
+     * code: column of the node in its level plus 1, or 0 before it is
+     *       given one and once it is found equivalent to another node
+     * column: column of the input node (ZddSubsetterMP only)
      */
     union SpecNode {
-        NodeId* srcPtr;
         int64_t code;
+        size_t hash;
     };
 
-    static NodeId*& srcPtr(SpecNode* p) {
-        return p[0].srcPtr;
+    static int64_t& code(SpecNode* p) {
+        return p[0].code;
     }
 
-    static int64_t& code(SpecNode* p) {
-        return p[1].code;
+    static int64_t code(SpecNode const* p) {
+        return p[0].code;
     }
 
-    static NodeId& nodeId(SpecNode* p) {
-        return *reinterpret_cast<NodeId*>(&p[1].code);
+    static size_t& hash(SpecNode* p) {
+        return p[1].hash;
     }
 
-    static NodeId nodeId(SpecNode const* p) {
-        return *reinterpret_cast<NodeId const*>(&p[1].code);
+    static size_t hash(SpecNode const* p) {
+        return p[1].hash;
+    }
+
+    static int64_t& column(SpecNode* p) {
+        return p[2].code;
+    }
+
+    static int64_t column(SpecNode const* p) {
+        return p[2].code;
     }
 
     static void* state(SpecNode* p) {
@@ -149,21 +161,280 @@ protected:
         return headerSize + (n + sizeof(SpecNode) - 1) / sizeof(SpecNode);
     }
 
+    /**
+     * Node waiting for a unique table with room for it.
+     */
+    struct Parked {
+        SpecNode* node;
+        NodeId* srcPtr;
+
+        Parked(SpecNode* node, NodeId* srcPtr) :
+                node(node), srcPtr(srcPtr) {
+        }
+    };
+
+    /**
+     * Equivalence of the nodes of one level, given to SharedUniqTable.
+     * Nodes of different input columns are never equivalent.
+     */
     template<typename SPEC>
-    struct Hasher {
-        SPEC const& spec;
+    struct StateKey {
+        SPEC& spec;
         int const level;
 
-        Hasher(SPEC const& spec, int level) :
+        StateKey(SPEC& spec, int level) :
                 spec(spec), level(level) {
         }
 
-        size_t operator()(SpecNode const* p) const {
-            return spec.hash_code(state(p), level);
+        bool equal(SpecNode const* p, SpecNode const* q) const {
+            return column(p) == column(q)
+                    && spec.equal_to(state(p), state(q), level);
         }
 
-        size_t operator()(SpecNode const* p, SpecNode const* q) const {
-            return spec.equal_to(state(p), state(q), level);
+        int merge(SpecNode* p, SpecNode* q) const {
+            return spec.merge_states(state(p), state(q));
+        }
+
+        /**
+         * Releases a node of the table that merge_states forwarded to the
+         * 0-terminal.
+         */
+        void retire(SpecNode* p) const {
+            spec.destruct(state(p));
+        }
+    };
+
+    /**
+     * Unique table of the nodes of one level, shared by all the threads.
+     * The nodes are added while the levels above are built, as soon as
+     * they are made, so that a level is already free of duplicates when it
+     * is built itself.
+     * A slot is one word: the node pointer, 16 bits of fingerprint taken
+     * from the hash code above it, and a lock bit below it. A pointer
+     * that does not fit in 48 bits (with 5-level paging or tagged
+     * pointers) is checked for when it is stored, and kept whole with a
+     * wide bit instead of the fingerprint; such a slot is compared with
+     * every node that probes it. A node is put
+     * into an empty slot by compare-and-swap. A thread whose fingerprint
+     * matches a slot locks it while it calls equal_to and merge_states, so
+     * that a state is never read while it is merged.
+     * A node is given its column when it takes an empty slot, so that the
+     * column can be read as soon as the node is found. Columns are given
+     * out up to the capacity of the table; a node that finds no room is
+     * added by the caller later, after the table is grown with reserve().
+     * A column given to no live node (because an equal node took the slot
+     * first, or merge_states forwarded it to the 0-terminal) is dead.
+     * Before a level is built, its columns are mapped to the nodes, so
+     * that the level is built in column order and a dead column is seen
+     * as one without a node.
+     */
+    class SharedUniqTable {
+        static int const MAX_FILL = 75;
+        static int const FINGERPRINT_SHIFT = 48;
+        static uint64_t const POINTER_MASK =
+                (uint64_t(1) << FINGERPRINT_SHIFT) - 1;
+        static uint64_t const LOCKED = 1;
+        static uint64_t const WIDE = 2;
+
+        MyVector<uint64_t> table;
+        // the node of each column, or null for a dead column
+        MyVector<SpecNode*> nodes;
+        // the number of columns given out
+        size_t count;
+        // the number of columns that may be given out
+        size_t limit;
+
+        static uint64_t fingerprint(size_t h) {
+            return (uint64_t(h) * 0x9E3779B97F4A7C15ULL) & ~POINTER_MASK;
+        }
+
+        static SpecNode* pointer(uint64_t w) {
+            uint64_t const mask = (w & WIDE) ? ~uint64_t(0) : POINTER_MASK;
+            return reinterpret_cast<SpecNode*>(w & mask & ~(LOCKED | WIDE));
+        }
+
+        static uint64_t slot(SpecNode* p) {
+            uint64_t const w = reinterpret_cast<uint64_t>(p);
+            assert((w & (LOCKED | WIDE)) == 0);
+            if (w & ~POINTER_MASK) return w | WIDE;
+            return fingerprint(hash(p)) | w;
+        }
+
+        /**
+         * Tells if the node in slot word w may be equivalent to a node of
+         * fingerprint fp.
+         */
+        static bool mayMatch(uint64_t w, uint64_t fp) {
+            return (w & WIDE) || (w & ~POINTER_MASK) == fp;
+        }
+
+        uint64_t load(size_t i) const {
+            return __atomic_load_n(&table[i], __ATOMIC_ACQUIRE);
+        }
+
+        void store(size_t i, uint64_t w) {
+            __atomic_store_n(&table[i], w, __ATOMIC_RELEASE);
+        }
+
+        bool swap(size_t i, uint64_t& w, uint64_t ww) {
+            return __atomic_compare_exchange_n(&table[i], &w, ww, false,
+                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+        }
+
+        int64_t newColumn() {
+            return __atomic_fetch_add(&count, 1, __ATOMIC_RELAXED);
+        }
+
+    public:
+        SharedUniqTable() :
+                count(0), limit(0) {
+        }
+
+        /**
+         * Gets the number of columns given out.
+         * @return the number of columns.
+         */
+        size_t size() const {
+            return count;
+        }
+
+        /**
+         * Gets the number of slots.
+         * @return the number of slots.
+         */
+        size_t tableSize() const {
+            return table.size();
+        }
+
+        /**
+         * Clears the map from the columns to the nodes for mapSlot().
+         * Not thread-safe.
+         */
+        void initColumns() {
+            nodes.clear();
+            nodes.resize(count);
+        }
+
+        /**
+         * Maps the column of the node in a slot, if any, to the node.
+         * @param i slot index.
+         */
+        void mapSlot(size_t i) {
+            SpecNode* p = pointer(table[i]);
+            if (p != 0) nodes[code(p) - 1] = p;
+        }
+
+        /**
+         * Gets the node of a column, once the slots are mapped.
+         * @param j column index.
+         * @return the node, or null for a dead column.
+         */
+        SpecNode* node(size_t j) const {
+            return nodes[j];
+        }
+
+        /**
+         * Makes room for columns to be given out up to a number, moving
+         * the nodes to a larger table if needed. Not thread-safe.
+         * @param n the number of columns.
+         */
+        void reserve(size_t n) {
+            if (n <= limit && !table.empty()) return;
+            MyVector<uint64_t> tmp(
+                    MyHashConstant::primeSize(n * 100 / MAX_FILL + 1));
+            for (size_t i = 0; i < table.size(); ++i) {
+                SpecNode* p = pointer(table[i]);
+                if (p == 0) continue;
+                size_t j = hash(p) % tmp.size();
+                while (tmp[j] != 0) {
+                    if (++j == tmp.size()) j = 0;
+                }
+                tmp[j] = table[i];
+            }
+            table.swap(tmp);
+            limit = table.size() * MAX_FILL / 100;
+        }
+
+        /**
+         * Forgets all the nodes. Not thread-safe.
+         */
+        void clear() {
+            table.clear();
+            nodes.clear();
+            count = 0;
+            limit = 0;
+        }
+
+        /**
+         * Finds the node equivalent to p or adds p.
+         * The hash code and the state of p must be set, and code(p) must
+         * be 0 unless p has been given a column before.
+         * Unless -1 is returned, code(p) is positive on return if p is in
+         * the table and 0 otherwise; in the latter case the state of p is
+         * left to the caller.
+         * @param p the node.
+         * @param key equivalence of the nodes.
+         * @return the code of the node found or added, 0 for the
+         *         0-terminal, or -1 if there is no room for p.
+         */
+        template<typename KEY>
+        int64_t add(SpecNode* p, KEY const& key) {
+            if (table.empty()) {
+                if (code(p) == 0) code(p) = newColumn() + 1;
+                return -1;
+            }
+
+            uint64_t const fp = fingerprint(hash(p));
+            size_t i = hash(p) % table.size();
+            uint64_t w = load(i);
+
+            for (;;) {
+                if (w == 0) {
+                    if (code(p) == 0) {
+                        code(p) = newColumn() + 1;
+                        if (size_t(code(p)) > limit) return -1;
+                    }
+                    if (swap(i, w, slot(p))) return code(p);
+                    continue; // look at the node that took the slot
+                }
+
+                if (!mayMatch(w, fp)) {
+                    if (++i == table.size()) i = 0;
+                    w = load(i);
+                    continue;
+                }
+
+                if (w & LOCKED) {
+                    std::this_thread::yield();
+                    w = load(i);
+                    continue;
+                }
+
+                if (!swap(i, w, w | LOCKED)) continue;
+                SpecNode* q = pointer(w);
+
+                if (!key.equal(q, p)) {
+                    store(i, w);
+                    if (++i == table.size()) i = 0;
+                    w = load(i);
+                    continue;
+                }
+
+                int64_t c = code(q);
+                switch (key.merge(q, p)) {
+                case 1:
+                    if (code(p) == 0) code(p) = newColumn() + 1;
+                    key.retire(q);
+                    store(i, slot(p));
+                    return code(p);
+                case 2:
+                    c = 0;
+                    break;
+                }
+                store(i, w);
+                code(p) = 0;
+                return c;
+            }
         }
     };
 };
@@ -183,6 +454,11 @@ class DdBuilder: DdBuilderBase {
     DdSweeper<AR> sweeper;
 
     MyVector<MyList<SpecNode> > snodeTable;
+    // size of the nodes of each level, by Spec::datasize_at(level)
+    MyVector<int> snodeSize;
+    // a whole state where a child is computed before it is copied into
+    // a node of its level, if that level has smaller nodes
+    MyVector<SpecNode> scratch;
 
     MyVector<char> oneStorage;
     void* const one;
@@ -190,6 +466,10 @@ class DdBuilder: DdBuilderBase {
 
     void init(int n) {
         snodeTable.resize(n + 1);
+        snodeSize.resize(n + 1);
+        for (int i = 0; i <= n; ++i) {
+            snodeSize[i] = getSpecNodeSize(spec.datasize_at(i));
+        }
         if (n >= output.numRows()) output.setNumRows(n + 1);
         oneSrcPtr.clear();
     }
@@ -200,6 +480,7 @@ public:
             specNodeSize(getSpecNodeSize(spec.datasize())),
             output(output.privateEntity()),
             sweeper(this->output, oneSrcPtr),
+            scratch(specNodeSize),
             oneStorage(spec.datasize()),
             one(oneStorage.data()) {
         if (n >= 1) init(n);
@@ -219,8 +500,8 @@ public:
      * @param s node state of the event.
      */
     void schedule(NodeId* fp, int level, void* s) {
-        SpecNode* p0 = snodeTable[level].alloc_front(specNodeSize);
-        spec.get_copy(state(p0), s);
+        SpecNode* p0 = snodeTable[level].alloc_front(snodeSize[level]);
+        spec.get_copy_at(state(p0), s, level);
         srcPtr(p0) = fp;
     }
 
@@ -303,7 +584,12 @@ public:
         output[i].resize(m);
         Node<AR>* const outi = output[i].data();
         size_t jj = j0;
-        SpecNode* pp = snodeTable[i - 1].alloc_front(specNodeSize);
+        // A child at level i - 1 is computed right in a new node of that
+        // level when the nodes there hold whole states, and otherwise in
+        // scratch, to be copied into a node of the size of its level.
+        bool const inPlace = snodeSize[i - 1] == specNodeSize;
+        SpecNode* pp = inPlace ?
+                snodeTable[i - 1].alloc_front(specNodeSize) : scratch.data();
 
         for (; !snodes.empty(); snodes.pop_front()) {
             SpecNode* p = snodes.front();
@@ -322,7 +608,7 @@ public:
                     continue;
                 }
 
-                spec.get_copy(state(pp), state(p));
+                spec.get_copy_at(state(pp), state(p), i);
                 int ii = spec.get_child(state(pp), i, b);
 
                 if (ii == 0) {
@@ -361,15 +647,15 @@ public:
                     spec.destruct(state(pp));
                     allZero = false;
                 }
-                else if (ii == i - 1) {
+                else if (ii == i - 1 && inPlace) {
                     srcPtr(pp) = &q.branch[b];
                     pp = snodeTable[ii].alloc_front(specNodeSize);
                     allZero = false;
                 }
                 else {
-                    assert(ii < i - 1);
-                    SpecNode* ppp = snodeTable[ii].alloc_front(specNodeSize);
-                    spec.get_copy(state(ppp), state(pp));
+                    assert(ii < i);
+                    SpecNode* ppp = snodeTable[ii].alloc_front(snodeSize[ii]);
+                    spec.get_copy_at(state(ppp), state(pp), ii);
                     spec.destruct(state(pp));
                     srcPtr(ppp) = &q.branch[b];
                     if (ii < lowestChild) lowestChild = ii;
@@ -382,7 +668,7 @@ public:
             if (allZero) ++deadCount;
         }
 
-        snodeTable[i - 1].pop_front();
+        if (inPlace) snodeTable[i - 1].pop_front();
         spec.destructLevel(i);
         sweeper.update(i, lowestChild, deadCount);
     }
@@ -394,52 +680,83 @@ public:
 template<typename S>
 class DdBuilderMP: DdBuilderMPBase {//TODO oneStorage
     typedef S Spec;
-    typedef MyHashTable<SpecNode*,Hasher<Spec>,Hasher<Spec> > UniqTable;
     static int const AR = Spec::ARITY;
-    static int const TASKS_PER_THREAD = 10;
 
     int const threads;
-    int const tasks;
 
     MyVector<Spec> specs;
     int const specNodeSize;
     NodeTableEntity<AR>& output;
     DdSweeper<AR> sweeper;
 
-    MyVector<MyVector<MyVector<MyList<SpecNode> > > > snodeTables;
+    MyVector<SharedUniqTable> uniqTables;
+    MyVector<MyVector<MyList<SpecNode> > > snodeTables;
+    MyVector<MyVector<MyVector<Parked> > > parkedTables;
 
 #ifdef DEBUG
-    ElapsedTimeCounter etcP1, etcP2, etcS1;
+    ElapsedTimeCounter etcP1, etcS1;
 #endif
 
     void init(int n) {
+        uniqTables.resize(n + 1);
         for (int y = 0; y < threads; ++y) {
-            snodeTables[y].resize(tasks);
-            for (int x = 0; x < tasks; ++x) {
-                snodeTables[y][x].resize(n + 1);
-            }
+            snodeTables[y].resize(n + 1);
+            parkedTables[y].resize(n + 1);
         }
         if (n >= output.numRows()) output.setNumRows(n + 1);
     }
 
+    /**
+     * Makes a node of a state in thread y and finds or adds it in the
+     * unique table of its level.
+     * @param y thread number.
+     * @param level node level.
+     * @param s node state, which is left as it is.
+     * @param f where the node ID is stored, now or when the level is
+     *          built if there is no room in the table.
+     * @return false if f is the 0-terminal.
+     */
+    bool add(int y, int level, void const* s, NodeId* f) {
+        Spec& spec = specs[y];
+        MyList<SpecNode>& snodes = snodeTables[y][level];
+        SpecNode* p = snodes.alloc_front(specNodeSize);
+        spec.get_copy(state(p), s);
+        code(p) = 0;
+        hash(p) = spec.hash_code(state(p), level);
+        column(p) = 0;
+
+        StateKey<Spec> key(spec, level);
+        int64_t c = uniqTables[level].add(p, key);
+        if (c < 0) {
+            parkedTables[y][level].push_back(Parked(p, f));
+            return true;
+        }
+
+        *f = c ? NodeId(level, c - 1) : NodeId(0); // c >= 1
+        if (code(p) == 0) {
+            spec.destruct(state(p));
+            snodes.pop_front();
+        }
+        return c != 0;
+    }
+
 public:
     DdBuilderMP(Spec const& s, NodeTableHandler<AR>& output, int n = 0) :
 #ifdef _OPENMP
             threads(omp_get_max_threads()),
-            tasks(MyHashConstant::primeSize(TASKS_PER_THREAD * threads)),
 #else
             threads(1),
-            tasks(1),
 #endif
             specs(threads, s),
             specNodeSize(getSpecNodeSize(s.datasize())),
             output(output.privateEntity()),
             sweeper(this->output),
-            snodeTables(threads) {
+            snodeTables(threads),
+            parkedTables(threads) {
         if (n >= 1) init(n);
 #ifdef DEBUG
         MessageHandler mh;
-        mh << "#thread = " << threads << ", #task = " << tasks;
+        mh << "#thread = " << threads;
 #endif
     }
 
@@ -447,7 +764,6 @@ public:
     ~DdBuilderMP() {
         MessageHandler mh;
         mh << "P1: " << etcP1 << "\n";
-        mh << "P2: " << etcP2 << "\n";
         mh << "S1: " << etcS1 << "\n";
     }
 #endif
@@ -459,9 +775,9 @@ public:
      * @param s node state of the event.
      */
     void schedule(NodeId* fp, int level, void* s) {
-        SpecNode* p0 = snodeTables[0][0][level].alloc_front(specNodeSize);
-        specs[0].get_copy(state(p0), s);
-        srcPtr(p0) = fp;
+        SharedUniqTable& uniq = uniqTables[level];
+        uniq.reserve(uniq.size() + 1);
+        add(0, level, s, fp);
     }
 
     /**
@@ -489,17 +805,42 @@ public:
 
     /**
      * Builds one level.
+     * The nodes of the level are numbered by now, except those still
+     * waiting for room in its table; their children go straight into the
+     * unique tables of the levels below.
      * @param i level.
      */
     void construct(int i) {
         assert(0 < i && i < output.numRows());
-        assert(output.numRows() - snodeTables[0][0].size() == 0);
+        assert(output.numRows() - uniqTables.size() == 0);
 
-        MyVector<size_t> nodeColumn(tasks);
+        SharedUniqTable& uniq = uniqTables[i];
+        size_t const m = uniq.size();
         int lowestChild = i - 1;
         size_t deadCount = 0;
 
 #ifdef DEBUG
+        etcS1.start();
+#endif
+        // Every node of this level gets room in its table now. Level i - 1
+        // gets room for as many new nodes as this level has, and a level
+        // further down for as many as it has; a child that finds no room
+        // waits until its level is built. A sparser table is slower to
+        // probe than the few children that wait.
+        uniq.reserve(m);
+        for (int ii = 1; ii < i; ++ii) {
+            SharedUniqTable& t = uniqTables[ii];
+            if (ii == i - 1) {
+                t.reserve(t.size() + m);
+            }
+            else if (t.size() > 0) {
+                t.reserve(t.size() * 2);
+            }
+        }
+        output.initRow(i, m);
+        uniq.initColumns();
+#ifdef DEBUG
+        etcS1.stop();
         etcP1.start();
 #endif
 
@@ -518,142 +859,80 @@ public:
             Spec& spec = specs[yy];
             MyVector<char> tmp(spec.datasize());
             void* const tmpState = tmp.data();
-            Hasher<Spec> hasher(spec, i);
-            UniqTable uniq(hasher, hasher);
             int lc = lowestChild;
 
+            StateKey<Spec> key(spec, i);
+
 #ifdef _OPENMP
 #pragma omp for schedule(dynamic)
 #endif
-            for (int x = 0; x < tasks; ++x) {
-                size_t m = 0;
-                for (int y = 0; y < threads; ++y) {
-                    m += snodeTables[y][x][i].size();
-                }
-                if (m == 0) continue;
-
-                uniq.initialize(m * 2);
-                size_t j = 0;
-
-                for (int y = 0; y < threads; ++y) {
-                    MyList<SpecNode> &snodes = snodeTables[y][x][i];
-
-                    for (MyList<SpecNode>::iterator t = snodes.begin();
-                            t != snodes.end(); ++t) {
-                        SpecNode* p = *t;
-                        SpecNode*& p0 = uniq.add(p);
+            for (int y = 0; y < threads; ++y) {
+                MyVector<Parked>& parked = parkedTables[y][i];
 
-                        if (p0 == p) {
-                            code(p) = ++j; // code(p) >= 1
-                        }
-                        else {
-                            switch (spec.merge_states(state(p0), state(p))) {
-                            case 1:
-                                code(p0) = 0;
-                                code(p) = ++j; // code(p) >= 1
-                                p0 = p;
-                                break;
-                            case 2:
-                                code(p) = 0;
-                                break;
-                            default:
-                                code(p) = -code(p0);
-                                break;
-                            }
-                        }
-                    }
+                for (size_t k = 0; k < parked.size(); ++k) {
+                    SpecNode* p = parked[k].node;
+                    int64_t c = uniq.add(p, key); // c >= 0
+                    *parked[k].srcPtr = c ? NodeId(i, c - 1) : NodeId(0);
+                    if (code(p) == 0) spec.destruct(state(p));
                 }
 
-                nodeColumn[x] = j;
-//#ifdef DEBUG
-//                MessageHandler mh;
-//#ifdef _OPENMP
-//#pragma omp critical
-//#endif
-//                mh << "table_size[" << i << "][" << x << "] = " << uniq.tableSize() << "\n";
-//#endif
+                parked.clear();
             }
 
 #ifdef _OPENMP
-#pragma omp single
-#endif
-            {
-#ifdef DEBUG
-                etcP1.stop();
-                etcS1.start();
-#endif
-                size_t m = output[i].size();
-                for (int x = 0; x < tasks; ++x) {
-                    size_t j = nodeColumn[x];
-                    nodeColumn[x] = (j >= 1) ? m : -1; // -1 for skip
-                    m += j;
-                }
-
-                output.initRow(i, m);
-#ifdef DEBUG
-                etcS1.stop();
-                etcP2.start();
+#pragma omp for schedule(static)
 #endif
+            for (intmax_t k = 0; k < intmax_t(uniq.tableSize()); ++k) {
+                uniq.mapSlot(k);
             }
 
 #ifdef _OPENMP
-#pragma omp for schedule(dynamic)
+#pragma omp for schedule(dynamic, 1024)
 #endif
-            for (int x = 0; x < tasks; ++x) {
-                if (nodeColumn[x] < 0) continue; // -1 for skip
-                size_t j0 = nodeColumn[x] - 1;   // code(p) >= 1
-
-                for (int y = 0; y < threads; ++y) {
-                    MyList<SpecNode> &snodes = snodeTables[y][x][i];
-
-                    for (; !snodes.empty(); snodes.pop_front()) {
-                        SpecNode* p = snodes.front();
+            for (intmax_t j = 0; j < intmax_t(m); ++j) {
+                SpecNode* p = uniq.node(j);
+                Node<AR> &q = output[i][j];
 
-                        if (code(p) <= 0) {
-                            *srcPtr(p) = code(p) ? NodeId(i, j0 - code(p)) : 0;
-                            spec.destruct(state(p));
-                            continue;
-                        }
+                if (p == 0) {
+                    q = Node<AR>(0, 0);
+                    ++deadCount;
+                    continue;
+                }
 
-                        size_t j = j0 + code(p);
-                        *srcPtr(p) = NodeId(i, j);
+                bool allZero = true;
+                void* s = tmpState;
 
-                        Node<AR> &q = output[i][j];
-                        bool allZero = true;
-                        void* s = tmpState;
+                for (int b = 0; b < AR; ++b) {
+                    if (b < AR - 1) {
+                        spec.get_copy(s, state(p));
+                    }
+                    else {
+                        s = state(p);
+                    }
 
-                        for (int b = 0; b < AR; ++b) {
-                            if (b < AR - 1) {
-                                spec.get_copy(s, state(p));
-                            }
-                            else {
-                                s = state(p);
-                            }
+                    int ii = spec.get_child(s, i, b);
 
-                            int ii = spec.get_child(s, i, b);
+                    if (ii <= 0) {
+                        q.branch[b] = ii ? 1 : 0;
+                        if (ii) allZero = false;
+                    }
+                    else {
+                        assert(ii <= i - 1);
+                        if (add(yy, ii, s, &q.branch[b])) allZero = false;
+                        if (ii < lc) lc = ii;
+                    }
 
-                            if (ii <= 0) {
-                                q.branch[b] = ii ? 1 : 0;
-                                if (ii) allZero = false;
-                            }
-                            else {
-                                assert(ii <= i - 1);
-                                int xx = spec.hash_code(s, ii) % tasks;
-                                SpecNode* pp =
-                                        snodeTables[yy][xx][ii].alloc_front(
-                                                specNodeSize);
-                                spec.get_copy(state(pp), s);
-                                srcPtr(pp) = &q.branch[b];
-                                if (ii < lc) lc = ii;
-                                allZero = false;
-                            }
+                    spec.destruct(s);
+                }
 
-                            spec.destruct(s);
-                        }
+                if (allZero) ++deadCount;
+            }
 
-                        if (allZero) ++deadCount;
-                    }
-                }
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+            for (int y = 0; y < threads; ++y) {
+                snodeTables[y][i].clear();
             }
 
             spec.destructLevel(i);
@@ -664,9 +943,10 @@ public:
             if (lc < lowestChild) lowestChild = lc;
         }
 
+        uniq.clear();
         sweeper.update(i, lowestChild, deadCount);
 #ifdef DEBUG
-        etcP2.stop();
+        etcP1.stop();
 #endif
     }
 };
@@ -958,7 +1238,6 @@ template<typename S>
 class ZddSubsetterMP: DdBuilderMPBase { //TODO oneStorage
 //typedef typename std::remove_const<typename std::remove_reference<S>::type>::type Spec;
     typedef S Spec;
-    typedef MyHashTable<SpecNode*,Hasher<Spec>,Hasher<Spec> > UniqTable;
     static int const AR = Spec::ARITY;
 
     int const threads;
@@ -969,8 +1248,46 @@ class ZddSubsetterMP: DdBuilderMPBase { //TODO oneStorage
     NodeTableEntity<AR>& output;
     DdSweeper<AR> sweeper;
 
-    MyVector<MyVector<MyVector<MyListOnPool<SpecNode> > > > snodeTables;
+    MyVector<SharedUniqTable> uniqTables;
+    MyVector<MyVector<MyListOnPool<SpecNode> > > snodeTables;
     MyVector<MemoryPools> pools;
+    MyVector<MyVector<MyVector<Parked> > > parkedTables;
+
+    /**
+     * Makes a node of a state and an input node in thread y and finds or
+     * adds it in the unique table of its level.
+     * @param y thread number.
+     * @param f the input node.
+     * @param s node state, which is left as it is.
+     * @param g where the node ID is stored, now or when the level is
+     *          built if there is no room in the table.
+     * @return false if g is the 0-terminal.
+     */
+    bool add(int y, NodeId f, void const* s, NodeId* g) {
+        Spec& spec = specs[y];
+        int const level = f.row();
+        MyListOnPool<SpecNode>& snodes = snodeTables[y][level];
+        SpecNode* p = snodes.alloc_front(pools[y][level], specNodeSize);
+        spec.get_copy(state(p), s);
+        code(p) = 0;
+        hash(p) = spec.hash_code(state(p), level) * 314159257
+                + f.col() * 271828171;
+        column(p) = f.col();
+
+        StateKey<Spec> key(spec, level);
+        int64_t c = uniqTables[level].add(p, key);
+        if (c < 0) {
+            parkedTables[y][level].push_back(Parked(p, g));
+            return true;
+        }
+
+        *g = c ? NodeId(level, c - 1) : NodeId(0); // c >= 1
+        if (code(p) == 0) {
+            spec.destruct(state(p));
+            snodes.pop_front();
+        }
+        return c != 0;
+    }
 
 public:
     ZddSubsetterMP(NodeTableHandler<AR> const& input,
@@ -988,7 +1305,8 @@ public:
             output(output.privateEntity()),
             sweeper(this->output),
             snodeTables(threads),
-            pools(threads) {
+            pools(threads),
+            parkedTables(threads) {
     }
 
     /**
@@ -1024,16 +1342,15 @@ public:
             assert(n == k);
             assert(n == root.row());
 
+            uniqTables.resize(n + 1);
             for (int y = 0; y < threads; ++y) {
                 snodeTables[y].resize(n + 1);
                 pools[y].resize(n + 1);
+                parkedTables[y].resize(n + 1);
             }
 
-            snodeTables[0][n].resize(input[n].size());
-            SpecNode* p0 = snodeTables[0][n][root.col()].alloc_front(
-                    pools[0][n], specNodeSize);
-            spec.get_copy(state(p0), tmpState);
-            srcPtr(p0) = &root;
+            uniqTables[n].reserve(1);
+            add(0, root, tmpState, &root);
         }
 
         spec.destruct(tmpState);
@@ -1043,16 +1360,37 @@ public:
 
     /**
      * Builds one level.
+     * The nodes of the level are numbered by now, except those still
+     * waiting for room in its table; their children go straight into the
+     * unique tables of the levels below.
      * @param i level.
      */
     void subset(int i) {
         assert(0 < i && i < output.numRows());
-        size_t const m = input[i].size();
 
-        MyVector<size_t> nodeColumn(m);
+        SharedUniqTable& uniq = uniqTables[i];
+        size_t const m = uniq.size();
         int lowestChild = i - 1;
         size_t deadCount = 0;
 
+        // Every node of this level gets room in its table now. Level i - 1
+        // gets room for as many new nodes as this level has, and a level
+        // further down for as many as it has; a child that finds no room
+        // waits until its level is built. A sparser table is slower to
+        // probe than the few children that wait.
+        uniq.reserve(m);
+        for (int ii = 1; ii < i; ++ii) {
+            SharedUniqTable& t = uniqTables[ii];
+            if (ii == i - 1) {
+                t.reserve(t.size() + m);
+            }
+            else if (t.size() > 0) {
+                t.reserve(t.size() * 2);
+            }
+        }
+        output.initRow(i, m);
+        uniq.initColumns();
+
 #ifdef _OPENMP
         // OpenMP 2.0 does not support reduction(min:lowestChild)
 #pragma omp parallel reduction(+:deadCount)
@@ -1066,146 +1404,97 @@ public:
             Spec& spec = specs[yy];
             MyVector<char> tmp(spec.datasize());
             void* const tmpState = tmp.data();
-            Hasher<Spec> hasher(spec, i);
-            UniqTable uniq(hasher, hasher);
             int lc = lowestChild;
 
+            StateKey<Spec> key(spec, i);
+
 #ifdef _OPENMP
 #pragma omp for schedule(dynamic)
 #endif
-            for (intmax_t j = 0; j < intmax_t(m); ++j) {
-                size_t mm = 0;
-                for (int y = 0; y < threads; ++y) {
-                    if (snodeTables[y][i].empty()) continue;
-                    MyListOnPool<SpecNode> &snodes = snodeTables[y][i][j];
-                    mm += snodes.size();
-                }
-                uniq.initialize(mm * 2);
-                size_t jj = 0;
-
-                for (int y = 0; y < threads; ++y) {
-                    if (snodeTables[y][i].empty()) continue;
-                    MyListOnPool<SpecNode> &snodes = snodeTables[y][i][j];
-
-                    for (MyListOnPool<SpecNode>::iterator t = snodes.begin();
-                            t != snodes.end(); ++t) {
-                        SpecNode* p = *t;
-                        SpecNode* pp = uniq.add(p);
+            for (int y = 0; y < threads; ++y) {
+                MyVector<Parked>& parked = parkedTables[y][i];
 
-                        if (pp == p) {
-                            code(p) = ++jj; // code(p) >= 1
-                        }
-                        else {
-                            code(p) = -code(pp);
-                            if (int prune = spec.merge_states(state(pp),
-                                    state(p))) {
-                                if (prune & 1) code(pp) = 0;
-                                if (prune & 2) code(p) = 0;
-                            }
-                        }
-                    }
+                for (size_t k = 0; k < parked.size(); ++k) {
+                    SpecNode* p = parked[k].node;
+                    int64_t c = uniq.add(p, key); // c >= 0
+                    *parked[k].srcPtr = c ? NodeId(i, c - 1) : NodeId(0);
+                    if (code(p) == 0) spec.destruct(state(p));
                 }
 
-                nodeColumn[j] = jj;
+                parked.clear();
             }
 
 #ifdef _OPENMP
-#pragma omp single
+#pragma omp for schedule(static)
 #endif
-            {
-                size_t mm = 0;
-                for (size_t j = 0; j < m; ++j) {
-                    size_t jj = nodeColumn[j];
-                    nodeColumn[j] = mm;
-                    mm += jj;
-                }
-
-                output.initRow(i, mm);
+            for (intmax_t k = 0; k < intmax_t(uniq.tableSize()); ++k) {
+                uniq.mapSlot(k);
             }
 
 #ifdef _OPENMP
-#pragma omp for schedule(dynamic)
+#pragma omp for schedule(dynamic, 1024)
 #endif
             for (intmax_t j = 0; j < intmax_t(m); ++j) {
-                size_t const jj0 = nodeColumn[j] - 1;   // code(p) >= 1
-
-                for (int y = 0; y < threads; ++y) {
-                    if (snodeTables[y][i].empty()) continue;
-
-                    MyListOnPool<SpecNode> &snodes = snodeTables[y][i][j];
-
-                    for (MyListOnPool<SpecNode>::iterator t = snodes.begin();
-                            t != snodes.end(); ++t) {
-                        SpecNode* p = *t;
+                SpecNode* p = uniq.node(j);
+                Node<AR> &q = output[i][j];
 
-                        if (code(p) <= 0) {
-                            *srcPtr(p) = code(p) ? NodeId(i, jj0 - code(p)) : 0;
-                            spec.destruct(state(p));
-                            continue;
-                        }
-
-                        size_t const jj = jj0 + code(p);
-                        *srcPtr(p) = NodeId(i, jj);
-                        Node<AR> &q = output[i][jj];
-                        bool allZero = true;
-                        void* s = tmpState;
-
-                        for (int b = 0; b < AR; ++b) {
-                            if (b < AR - 1) {
-                                spec.get_copy(s, state(p));
-                            }
-                            else {
-                                s = state(p);
-                            }
-
-                            NodeId f(i, j);
-                            int kk = downTable(f, b, i - 1);
-                            int ii = downSpec(spec, s, i, b, kk);
-
-                            while (ii != 0 && kk != 0 && ii != kk) {
-                                if (ii < kk) {
-                                    assert(kk >= 1);
-                                    kk = downTable(f, 0, ii);
-                                }
-                                else {
-                                    assert(ii >= 1);
-                                    ii = downSpec(spec, s, ii, 0, kk);
-                                }
-                            }
+                if (p == 0) {
+                    q = Node<AR>(0, 0);
+                    ++deadCount;
+                    continue;
+                }
 
-                            if (ii <= 0 || kk <= 0) {
-                                bool val = ii != 0 && kk != 0;
-                                q.branch[b] = val;
-                                if (val) allZero = false;
-                            }
-                            else {
-                                assert(ii == f.row() && ii == kk && ii < i);
-                                size_t jj = f.col();
+                bool allZero = true;
+                void* s = tmpState;
 
-                                if (snodeTables[yy][ii].empty()) {
-                                    snodeTables[yy][ii].resize(
-                                            input[ii].size());
-                                }
+                for (int b = 0; b < AR; ++b) {
+                    if (b < AR - 1) {
+                        spec.get_copy(s, state(p));
+                    }
+                    else {
+                        s = state(p);
+                    }
 
-                                SpecNode* pp =
-                                        snodeTables[yy][ii][jj].alloc_front(
-                                                pools[yy][ii], specNodeSize);
-                                spec.get_copy(state(pp), s);
-                                srcPtr(pp) = &q.branch[b];
-                                if (ii < lc) lc = ii;
-                                allZero = false;
-                            }
+                    NodeId f(i, column(p));
+                    int kk = downTable(f, b, i - 1);
+                    int ii = downSpec(spec, s, i, b, kk);
 
-                            spec.destruct(s);
+                    while (ii != 0 && kk != 0 && ii != kk) {
+                        if (ii < kk) {
+                            assert(kk >= 1);
+                            kk = downTable(f, 0, ii);
+                        }
+                        else {
+                            assert(ii >= 1);
+                            ii = downSpec(spec, s, ii, 0, kk);
                         }
+                    }
 
-                        if (allZero) ++deadCount;
+                    if (ii <= 0 || kk <= 0) {
+                        bool val = ii != 0 && kk != 0;
+                        q.branch[b] = val;
+                        if (val) allZero = false;
                     }
+                    else {
+                        assert(ii == f.row() && ii == kk && ii < i);
+                        if (add(yy, f, s, &q.branch[b])) allZero = false;
+                        if (ii < lc) lc = ii;
+                    }
+
+                    spec.destruct(s);
                 }
+
+                if (allZero) ++deadCount;
+            }
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+            for (int y = 0; y < threads; ++y) {
+                snodeTables[y][i].clear();
+                pools[y][i].clear();
             }
 
-            snodeTables[yy][i].clear();
-            pools[yy][i].clear();
             spec.destructLevel(i);
 
 #ifdef _OPENMP
@@ -1214,6 +1503,7 @@ public:
             if (lc < lowestChild) lowestChild = lc;
         }
 
+        uniq.clear();
         sweeper.update(i, lowestChild, deadCount);
     }
 
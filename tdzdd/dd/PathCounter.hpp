@@ -69,6 +69,8 @@ class PathCounter {
 
     Spec& spec;
     int const stateWords;
+    size_t maxLevelStates;
+    size_t maxStates;
 
     static int numWords(int n) {
         if (n < 0) throw std::runtime_error(
@@ -92,11 +94,36 @@ class PathCounter {
         return p[stateWords];
     }
 
+    /**
+     * Destructs the states left on the levels up to i.
+     */
+    void giveUp(MyVector<MyList<Word> >& vnodeTable, int i) {
+        for (int ii = i; ii >= 0; --ii) {
+            MyList<Word>& vnodes = vnodeTable[ii];
+            for (; !vnodes.empty(); vnodes.pop_front()) {
+                spec.destruct(state(vnodes.front()));
+            }
+            spec.destructLevel(ii);
+        }
+    }
+
 public:
 //    PathCounter(S&& s): spec(std::forward<S>(s)), hasher(spec), stateWords(numWords(spec.datasize())) {
 //    }
     PathCounter(S& s)
-            : spec(s), stateWords(numWords(spec.datasize())) {
+            : spec(s), stateWords(numWords(spec.datasize())),
+              maxLevelStates(SIZE_MAX), maxStates(SIZE_MAX) {
+    }
+
+    /**
+     * Makes count() give up when a level gets more than a number of
+     * states or all the levels get more than another in total.
+     * @param levelStates the maximum number of states on a level.
+     * @param totalStates the maximum number of states in total.
+     */
+    void setLimits(size_t levelStates, size_t totalStates) {
+        maxLevelStates = levelStates;
+        maxStates = totalStates;
     }
 
     std::string count() {
@@ -116,6 +143,7 @@ public:
         BigNumber total(totalStorage.data());
         total.store(0);
         size_t maxWidth = 0;
+        size_t numStates = 0;
         //std::cerr << "\nLevel,Width\n";
 
         MemoryPools pools(n + 1);
@@ -143,6 +171,13 @@ public:
 
             //std::cerr << i << "," << m << "\n";
             maxWidth = std::max(maxWidth, m);
+            numStates += m;
+            if (numStates > maxStates) {
+                giveUp(vnodeTable, i);
+                mh << " gave up";
+                mh.end(maxWidth);
+                return "";
+            }
             MyList<Word>& nextVnodes = vnodeTable[i - 1];
             UniqTable& nextUniq = uniqTable[i - 1];
             int const nextWords = stateWords + numberWords + 1;
@@ -205,6 +240,15 @@ public:
                 }
 
                 spec.destruct(state(p));
+
+                if (nextVnodes.size() > maxLevelStates) {
+                    vnodes.pop_front();
+                    nextVnodes.pop_front();
+                    giveUp(vnodeTable, i);
+                    mh << " gave up";
+                    mh.end(maxLevelStates);
+                    return "";
+                }
             }
 
             nextVnodes.pop_front();
@@ -445,6 +489,23 @@ std::string countPaths(S& spec, bool fast = false) {
     return fast ? pc.countFast() : pc.count();
 }
 
+/**
+ * Counts the number of paths from the root to the 1-terminal
+ * without building entire DD structure, unless it takes too many states.
+ * This function uses arbitrary-precision integer for counting.
+ * @param spec DD specification.
+ * @param levelStates the maximum number of states on a level.
+ * @param totalStates the maximum number of states in total.
+ * @return the number, or an empty string if it took too many states.
+ */
+template<typename S>
+std::string countPathsWithin(S& spec, size_t levelStates,
+        size_t totalStates) {
+    PathCounter<S> pc(spec);
+    pc.setLimits(levelStates, totalStates);
+    return pc.count();
+}
+
 /**
  * Counts the number of paths from the root to the 1-terminal
  * without building entire DD structure.
@@ -36,10 +36,17 @@
 #include <sstream>
 #include <stdexcept>
 #include <stdint.h>
+#include <thread>
 #include <vector>
 #include <stack>
+#include <unordered_map>
 #include <unordered_set>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 namespace tdzdd {
 
 class Graph {
@@ -79,28 +86,98 @@ public:
         }
     };
 
+    /**
+     * Neighbors of a vertex: a view into the adjacency index of the graph,
+     * valid until the next update().
+     * edge(i) is the edge number between the vertex and its i-th neighbor.
+     */
+    class NeighborSpan {
+        VertexNumber const* first;
+        VertexNumber const* last;
+        EdgeNumber const* edges;
+
+    public:
+        NeighborSpan(VertexNumber const* first, VertexNumber const* last,
+                     EdgeNumber const* edges)
+                : first(first), last(last), edges(edges) {
+        }
+
+        VertexNumber const* begin() const {
+            return first;
+        }
+
+        VertexNumber const* end() const {
+            return last;
+        }
+
+        size_t size() const {
+            return last - first;
+        }
+
+        VertexNumber operator[](size_t i) const {
+            return first[i];
+        }
+
+        EdgeNumber edge(size_t i) const {
+            return edges[i];
+        }
+    };
+
+    /**
+     * Blocks (biconnected components), bridges and articulation points
+     * of a graph, as found by decomposeBlocks().
+     */
+    struct BlockDecomposition {
+        // blockOf[a]: block number of edge a; a bridge or a self-loop is a
+        // block by itself
+        std::vector<int> blockOf;
+        // isBridge[a]: whether edge a is a bridge
+        std::vector<bool> isBridge;
+        // isArticulation[v]: whether vertex v is an articulation point
+        std::vector<bool> isArticulation;
+        // number of blocks
+        int numBlocks;
+    };
+
     static VertexNumber const MAX_VERTICES = USHRT_MAX;
     static EdgeNumber const MAX_EDGES = INT_MAX;
     static ColorNumber const MAX_COLORS = USHRT_MAX;
 
 private:
     std::vector<std::pair<std::string,std::string> > edgeNames;
+    // edges given as pairs of indices into indexedName_, as read by the
+    // numeric readers or set by setIndexedEdges(); used instead of
+    // edgeNames until an edge is added by name
+    std::vector<std::pair<int,int> > indexedEdges_;
+    std::vector<std::string> indexedName_;
     std::map<std::string,std::string> name2label;
     std::map<std::string,std::string> name2color;
-    std::map<std::string,VertexNumber> name2vertex;
+    // filled by update(), or on the first name lookup after
+    // setUpdatedState()
+    mutable std::map<std::string,VertexNumber> name2vertex;
     std::vector<std::string> vertex2name;
-    std::map<std::pair<std::string,std::string>,EdgeNumber> name2edge;
-    std::vector<std::pair<std::string,std::string> > edge2name;
     std::vector<EdgeInfo> edgeInfo_;
-    std::map<VertexNumberPair,EdgeNumber> edgeIndex;
+    // edgeReversed_[a]: whether edge a was named as (v2, v1)
+    std::vector<bool> edgeReversed_;
     std::vector<VertexNumber> virtualMate_;
     std::vector<ColorNumber> colorNumber_;
+    // adjacency index in compressed sparse row form: the neighbors of v are
+    // adjVertex_[adjOffset_[v] .. adjOffset_[v+1]), in edge order, joined
+    // by the edges adjEdge_[...]
+    std::vector<int> adjOffset_;
+    std::vector<VertexNumber> adjVertex_;
+    std::vector<EdgeNumber> adjEdge_;
     VertexNumber vMax;
     ColorNumber numColor_;
     bool hasColorPairs_;
+    // block decomposition given by setBlockDecomposition(), returned by
+    // decomposeBlocks() until the next update()
+    BlockDecomposition knownBlocks_;
+    bool hasKnownBlocks_ = false;
 
 public:
     void addEdge(std::string vertexName1, std::string vertexName2) {
+        if (!indexedEdges_.empty()) nameIndexedEdges();
         edgeNames.push_back(std::make_pair(vertexName1, vertexName2));
     }
 
@@ -122,9 +199,11 @@ public:
         }
         else {
             mh << " \"" << filename << "\" ...";
-            std::ifstream fin(filename.c_str(), std::ios::in);
-            if (!fin) throw std::runtime_error(strerror(errno));
-            readEdges(fin);
+            if (!readNumericEdges(filename)) {
+                std::ifstream fin(filename.c_str(), std::ios::in);
+                if (!fin) throw std::runtime_error(strerror(errno));
+                readEdges(fin);
+            }
         }
 
         mh.end();
@@ -169,8 +248,282 @@ public:
         update();
     }
 
+    /**
+     * Sets the edges as pairs of indices into names, so that edge i is
+     * names[edges[i].first]--names[edges[i].second], and updates.
+     */
+    void setIndexedEdges(std::vector<std::string> names,
+                         std::vector<std::pair<int,int> > edges) {
+        edgeNames.clear();
+        indexedName_ = std::move(names);
+        indexedEdges_ = std::move(edges);
+        update();
+    }
+
+    /**
+     * Adopts the state update() would compute for a graph saved before
+     * (such as one loaded from a cache) without redoing that work:
+     * vertexNames[v] is the name of vertex v (vertexNames[0] is unused),
+     * edge a is edges[a], named in reverse if reversed[a], and the
+     * adjacency index is given in the form of neighbors(). Colors and
+     * labels are dropped, and so are the edges given before, so edges added
+     * afterwards start a new graph.
+     */
+    void setUpdatedState(std::vector<std::string> vertexNames,
+                         std::vector<EdgeInfo> edges,
+                         std::vector<bool> reversed,
+                         std::vector<int> adjOffset,
+                         std::vector<VertexNumber> adjVertex,
+                         std::vector<EdgeNumber> adjEdge) {
+        assert(!vertexNames.empty());
+        assert(reversed.size() == edges.size());
+        assert(adjOffset.size() == vertexNames.size() + 1);
+        edgeNames.clear();
+        indexedEdges_.clear();
+        indexedName_.clear();
+        name2label.clear();
+        name2color.clear();
+        name2vertex.clear();
+        hasKnownBlocks_ = false;
+        vMax = vertexNames.size() - 1;
+        vertex2name = std::move(vertexNames);
+        edgeInfo_ = std::move(edges);
+        edgeReversed_ = std::move(reversed);
+        adjOffset_ = std::move(adjOffset);
+        adjVertex_ = std::move(adjVertex);
+        adjEdge_ = std::move(adjEdge);
+        virtualMate_.assign(vMax + 1, 0);
+        colorNumber_.assign(vMax + 1, 0);
+        numColor_ = 0;
+        hasColorPairs_ = false;
+    }
+
+    /**
+     * Makes decomposeBlocks() return blocks, a decomposition of this graph
+     * found before (such as one loaded from a cache).
+     */
+    void setBlockDecomposition(BlockDecomposition const& blocks) {
+        assert(blocks.blockOf.size() == size_t(edgeSize()));
+        knownBlocks_ = blocks;
+        hasKnownBlocks_ = true;
+    }
+
+    /**
+     * Reads a Matrix Market coordinate file as the graph of the nonzero
+     * pattern: entry (i, j) is edge i--j. Comments are skipped, and so is
+     * the size line after the "%%MatrixMarket" banner. Entry values are
+     * ignored, diagonal entries (self-loops) are dropped, and of (i, j) and
+     * (j, i) only the first in the file is kept. Edges stay in file order.
+     */
+    void readMatrixMarket(std::string const& filename) {
+        tdzdd::MessageHandler mh;
+        mh.begin("reading");
+
+        if (filename.empty()) {
+            mh << " STDIN ...";
+            readMatrixMarket(std::cin);
+        }
+        else {
+            mh << " \"" << filename << "\" ...";
+            std::ifstream fin(filename.c_str(), std::ios::in);
+            if (!fin) throw std::runtime_error(strerror(errno));
+            readMatrixMarket(fin);
+        }
+
+        mh.end();
+        update();
+    }
+
 private:
+    /*
+     * Fast path of readEdges() for files whose vertex names are all
+     * decimal integers: the file is mapped into memory and cut at line
+     * ends into one chunk per thread, and the chunks are parsed in
+     * parallel straight into integers, so no per-character stream reads
+     * or name strings are needed. Returns false, having read nothing, if
+     * the graph already has edges, the file cannot be mapped, or any name
+     * is not a plain integer (this includes "007"-like names, which must
+     * stay distinct from "7"); readEdges() then falls back to the stream
+     * reader, which also reports malformed lines.
+     */
+    bool readNumericEdges(std::string const& filename) {
+        if (!edgeNames.empty() || !indexedEdges_.empty()) return false;
+
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            return false;
+        }
+        size_t const size = st.st_size;
+        void* map = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) return false;
+        char const* const text = static_cast<char const*>(map);
+
+        size_t const minChunk = 1 << 20;
+        size_t threads = std::thread::hardware_concurrency();
+        threads = std::max<size_t>(1,
+                std::min<size_t>(threads, size / minChunk));
+
+        // chunk t is text[cut[t] .. cut[t+1]), cut just after a newline
+        std::vector<size_t> cut(threads + 1, size);
+        cut[0] = 0;
+        for (size_t t = 1; t < threads; ++t) {
+            size_t c = std::max(size * t / threads, cut[t - 1]);
+            while (c < size && text[c - 1] != '\n') {
+                ++c;
+            }
+            cut[t] = c;
+        }
+
+        std::vector<std::vector<uint64_t> > labels(threads);
+        std::vector<char> ok(threads);
+        {
+            std::vector<std::thread> workers;
+            for (size_t t = 1; t < threads; ++t) {
+                workers.push_back(std::thread([&, t]() {
+                    ok[t] = parseEdgeChunk(text + cut[t], text + cut[t + 1],
+                                           labels[t]);
+                }));
+            }
+            ok[0] = parseEdgeChunk(text + cut[0], text + cut[1], labels[0]);
+            for (size_t t = 0; t < workers.size(); ++t) {
+                workers[t].join();
+            }
+        }
+        munmap(map, size);
+        for (size_t t = 0; t < threads; ++t) {
+            if (!ok[t]) return false;
+        }
+
+        // number the distinct labels in increasing order
+        size_t tokens = 0;
+        uint64_t maxLabel = 0;
+        for (size_t t = 0; t < threads; ++t) {
+            tokens += labels[t].size();
+            for (size_t i = 0; i < labels[t].size(); ++i) {
+                maxLabel = std::max(maxLabel, labels[t][i]);
+            }
+        }
+        if (tokens == 0) return false;
+        std::vector<uint64_t> label;
+        std::vector<int> table;
+        if (maxLabel < tokens + (1 << 16)) {
+            // labels are dense enough to be indices themselves
+            table.assign(maxLabel + 1, -1);
+            for (size_t t = 0; t < threads; ++t) {
+                for (size_t i = 0; i < labels[t].size(); ++i) {
+                    table[labels[t][i]] = 0;
+                }
+            }
+            for (uint64_t x = 0; x <= maxLabel; ++x) {
+                if (table[x] < 0) continue;
+                table[x] = label.size();
+                label.push_back(x);
+            }
+        }
+        else {
+            label.reserve(tokens);
+            for (size_t t = 0; t < threads; ++t) {
+                label.insert(label.end(), labels[t].begin(), labels[t].end());
+            }
+            sortUnique(label);
+        }
+
+        indexedEdges_.reserve(tokens / 2);
+        for (size_t t = 0; t < threads; ++t) {
+            std::vector<uint64_t> const& l = labels[t];
+            for (size_t i = 0; i < l.size(); i += 2) {
+                indexedEdges_.push_back(
+                        std::make_pair(numericId(label, table, l[i]),
+                                       numericId(label, table, l[i + 1])));
+            }
+        }
+        nameLabels(label);
+        return true;
+    }
+
+    static void sortUnique(std::vector<uint64_t>& label) {
+        std::sort(label.begin(), label.end());
+        label.erase(std::unique(label.begin(), label.end()), label.end());
+    }
+
+    // Returns the index of x in the sorted labels, looked up in table if
+    // it is not empty.
+    static int numericId(std::vector<uint64_t> const& label,
+                         std::vector<int> const& table, uint64_t x) {
+        if (!table.empty()) return table[x];
+        return std::lower_bound(label.begin(), label.end(), x) - label.begin();
+    }
+
+    void nameLabels(std::vector<uint64_t> const& label) {
+        indexedName_.reserve(label.size());
+        for (size_t i = 0; i < label.size(); ++i) {
+            indexedName_.push_back(
+                    std::to_string(static_cast<unsigned long long>(label[i])));
+        }
+    }
+
+    /*
+     * Appends the two integers of each line of text[begin .. end) to
+     * labels. Returns false on anything but lines of exactly two integers
+     * or blank lines.
+     */
+    static bool parseEdgeChunk(char const* p, char const* end,
+                               std::vector<uint64_t>& labels) {
+        labels.reserve((end - p) / 8);
+        int tokens = 0;
+        while (p < end) {
+            char c = *p;
+            if (c == '\n') {
+                if (tokens == 1) return false;
+                tokens = 0;
+                ++p;
+                continue;
+            }
+            if (isBlank(c)) {
+                ++p;
+                continue;
+            }
+            if (tokens == 2) return false;
+
+            char const* first = p;
+            uint64_t x = 0;
+            while (p < end && static_cast<unsigned char>(*p - '0') < 10) {
+                x = x * 10 + (*p - '0');
+                ++p;
+            }
+            size_t const digits = p - first;
+            if (digits == 0 || digits > 18) return false;
+            if (digits > 1 && *first == '0') return false;
+            if (p < end && *p != '\n' && !isBlank(*p)) return false;
+            labels.push_back(x);
+            ++tokens;
+        }
+        return tokens != 1;
+    }
+
+    // isspace() in the "C" locale, less '\n'
+    static bool isBlank(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    // Moves indexedEdges_ into edgeNames.
+    void nameIndexedEdges() {
+        edgeNames.reserve(edgeNames.size() + indexedEdges_.size());
+        for (size_t i = 0; i < indexedEdges_.size(); ++i) {
+            edgeNames.push_back(std::make_pair(
+                    indexedName_[indexedEdges_[i].first],
+                    indexedName_[indexedEdges_[i].second]));
+        }
+        indexedEdges_.clear();
+        indexedName_.clear();
+    }
+
     void readEdges(std::istream& is) {
+        if (!indexedEdges_.empty()) nameIndexedEdges();
         std::string v, v1, v2;
 
         while (is) {
@@ -217,8 +570,80 @@ private:
         }
     }
 
+    void readMatrixMarket(std::istream& is) {
+        edgeNames.clear();
+        indexedEdges_.clear();
+        indexedName_.clear();
+
+        // off-diagonal entries in file order
+        std::vector<std::pair<uint64_t,uint64_t> > entry;
+        bool banner = false;
+        bool sizeLine = false;
+        std::string line;
+
+        while (std::getline(is, line)) {
+            if (!line.empty() && line[0] == '%') {
+                if (entry.empty() && line.compare(0, 14, "%%MatrixMarket") == 0) {
+                    banner = true;
+                    if (line.find("array") != std::string::npos) {
+                        throw std::runtime_error(
+                                "ERROR: Only coordinate Matrix Market files are supported");
+                    }
+                }
+                continue;
+            }
+            if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+            if (banner && !sizeLine) {
+                sizeLine = true;
+                continue;
+            }
+
+            std::istringstream iss(line);
+            long long i, j;
+            if (!(iss >> i >> j) || i < 1 || j < 1) throw std::runtime_error(
+                    "ERROR: Bad Matrix Market entry: " + line);
+            if (i != j) entry.push_back(std::make_pair(i, j));
+        }
+
+        // sort-unique on (smaller index, larger index, position), keeping
+        // the first position of each pair
+        std::vector<std::pair<std::pair<uint64_t,uint64_t>,size_t> > key(entry.size());
+        for (size_t k = 0; k < entry.size(); ++k) {
+            key[k] = std::make_pair(
+                    std::make_pair(std::min(entry[k].first, entry[k].second),
+                                   std::max(entry[k].first, entry[k].second)),
+                    k);
+        }
+        std::sort(key.begin(), key.end());
+        std::vector<size_t> kept;
+        for (size_t k = 0; k < key.size(); ++k) {
+            if (k == 0 || key[k].first != key[k - 1].first) {
+                kept.push_back(key[k].second);
+            }
+        }
+        std::sort(kept.begin(), kept.end());
+
+        std::vector<uint64_t> label;
+        for (size_t k = 0; k < kept.size(); ++k) {
+            label.push_back(entry[kept[k]].first);
+            label.push_back(entry[kept[k]].second);
+        }
+        sortUnique(label);
+
+        std::vector<int> const noTable;
+        indexedEdges_.reserve(kept.size());
+        for (size_t k = 0; k < kept.size(); ++k) {
+            indexedEdges_.push_back(std::make_pair(
+                    numericId(label, noTable, entry[kept[k]].first),
+                    numericId(label, noTable, entry[kept[k]].second)));
+        }
+        nameLabels(label);
+    }
+
     void readAdjacencyList(std::istream& is) {
         edgeNames.clear();
+        indexedEdges_.clear();
+        indexedName_.clear();
         name2label.clear();
         name2color.clear();
 
@@ -274,49 +699,127 @@ private:
         return color;
     }
 
+    // Returns name2vertex, built from vertex2name if the state was set by
+    // setUpdatedState().
+    std::map<std::string,VertexNumber> const& nameIndex() const {
+        if (name2vertex.empty()) {
+            for (VertexNumber v = 1; v <= vMax; ++v) {
+                name2vertex[vertex2name[v]] = v;
+            }
+        }
+        return name2vertex;
+    }
+
+    void updateAdjacency() {
+        adjOffset_.assign(vMax + 2, 0);
+        for (EdgeNumber a = 0; a < edgeSize(); ++a) {
+            EdgeInfo const& e = edgeInfo_[a];
+            ++adjOffset_[e.v1 + 1];
+            if (e.v2 != e.v1) ++adjOffset_[e.v2 + 1];
+        }
+        for (VertexNumber v = 1; v <= vMax + 1; ++v) {
+            adjOffset_[v] += adjOffset_[v - 1];
+        }
+        adjVertex_.resize(adjOffset_[vMax + 1]);
+        adjEdge_.resize(adjOffset_[vMax + 1]);
+        std::vector<int> pos(adjOffset_.begin(), adjOffset_.end() - 1);
+        for (EdgeNumber a = 0; a < edgeSize(); ++a) {
+            EdgeInfo const& e = edgeInfo_[a];
+            adjVertex_[pos[e.v1]] = e.v2;
+            adjEdge_[pos[e.v1]++] = a;
+            if (e.v2 == e.v1) continue;
+            adjVertex_[pos[e.v2]] = e.v1;
+            adjEdge_[pos[e.v2]++] = a;
+        }
+    }
+
 public:
     /*
      * INPUT:
-     *   edgeNames
+     *   edgeNames (or indexedEdges_ and indexedName_)
      *   name2label
      *   name2color
      */
     void update() {
         name2vertex.clear();
         vertex2name.clear();
-        name2edge.clear();
-        edge2name.clear();
         edgeInfo_.clear();
-        edgeIndex.clear();
+        edgeReversed_.clear();
+        hasKnownBlocks_ = false;
         vMax = 0;
 
-        // Make unique edge name list
-        for (size_t i = 0; i < edgeNames.size(); ++i) {
-            std::pair<std::string,std::string> const& e = edgeNames[i];
-
-            if (name2edge.count(e) == 0) {
-                edge2name.push_back(e);
-                name2edge[e] = -1;
-                name2edge[std::make_pair(e.second, e.first)] = -1;
+        // Give vertex names dense ids
+        std::vector<std::string> nameOfId;
+        std::vector<std::pair<int,int> > nameIds;
+        if (indexedEdges_.empty()) {
+            std::unordered_map<std::string,int> name2id;
+            nameIds.reserve(edgeNames.size());
+            for (size_t i = 0; i < edgeNames.size(); ++i) {
+                std::pair<std::string,std::string> const& e = edgeNames[i];
+                std::pair<std::unordered_map<std::string,int>::iterator,bool> r1 =
+                        name2id.insert(std::make_pair(e.first, int(nameOfId.size())));
+                if (r1.second) nameOfId.push_back(e.first);
+                std::pair<std::unordered_map<std::string,int>::iterator,bool> r2 =
+                        name2id.insert(std::make_pair(e.second, int(nameOfId.size())));
+                if (r2.second) nameOfId.push_back(e.second);
+                nameIds.push_back(std::make_pair(r1.first->second, r2.first->second));
+            }
+        }
+        std::vector<std::string> const& idName =
+                indexedEdges_.empty() ? nameOfId : indexedName_;
+        std::vector<std::pair<int,int> > const& ids =
+                indexedEdges_.empty() ? nameIds : indexedEdges_;
+        int const n = idName.size();
+
+        // Make unique edge list: edges are bucketed by their smaller end in
+        // input order, and the first edge to each other end is kept
+        std::vector<std::pair<int,int> > uniqueIds;
+        {
+            std::vector<size_t> head(n + 1, 0);
+            for (size_t i = 0; i < ids.size(); ++i) {
+                ++head[std::min(ids[i].first, ids[i].second) + 1];
+            }
+            for (int u = 0; u < n; ++u) {
+                head[u + 1] += head[u];
+            }
+            std::vector<size_t> bucket(ids.size());
+            std::vector<size_t> pos(head.begin(), head.end() - 1);
+            for (size_t i = 0; i < ids.size(); ++i) {
+                bucket[pos[std::min(ids[i].first, ids[i].second)]++] = i;
+            }
+            std::vector<int> mark(n, -1);
+            std::vector<bool> first(ids.size());
+            for (int u = 0; u < n; ++u) {
+                for (size_t k = head[u]; k < head[u + 1]; ++k) {
+                    size_t i = bucket[k];
+                    int w = std::max(ids[i].first, ids[i].second);
+                    if (mark[w] == u) continue;
+                    mark[w] = u;
+                    first[i] = true;
+                }
+            }
+            for (size_t i = 0; i < ids.size(); ++i) {
+                if (first[i]) uniqueIds.push_back(ids[i]);
             }
         }
 
         // Sort vertices by leaving order
+        std::vector<VertexNumber> number(n, 0);
         {
-            std::vector<std::string> stack;
-            stack.reserve(edge2name.size() * 2);
+            std::vector<int> stack;
+            stack.reserve(n);
 
-            for (size_t i = edge2name.size() - 1; i + 1 > 0; --i) {
-                std::string const& s1 = edge2name[i].first;
-                std::string const& s2 = edge2name[i].second;
+            for (size_t i = uniqueIds.size() - 1; i + 1 > 0; --i) {
+                int s1 = uniqueIds[i].first;
+                int s2 = uniqueIds[i].second;
 
-                if (name2vertex.count(s2) == 0) {
-                    name2vertex[s2] = 0;
+                if (number[s2] == 0) {
+                    number[s2] = -1;
                     stack.push_back(s2);
                 }
 
-                if (name2vertex.count(s1) == 0) {
-                    name2vertex[s1] = 0;
+                if (number[s1] == 0) {
+                    number[s1] = -1;
                     stack.push_back(s1);
                 }
             }
@@ -324,45 +827,33 @@ public:
             vertex2name.push_back(""); // begin vertex number with 1
 
             while (!stack.empty()) {
-                std::string const& s = stack.back();
-                name2vertex[s] = vertex2name.size();
-                vertex2name.push_back(s);
+                int s = stack.back();
+                number[s] = vertex2name.size();
+                name2vertex[idName[s]] = number[s];
+                vertex2name.push_back(idName[s]);
                 if (vertex2name.size() > size_t(MAX_VERTICES)) throw std::runtime_error(
                         "ERROR: Vertex number > " + to_string(MAX_VERTICES));
                 stack.pop_back();
             }
         }
 
-        for (size_t i = 0; i < edge2name.size(); ++i) {
-            std::pair<std::string,std::string> const& e = edge2name[i];
-            std::string s1 = e.first;
-            std::string s2 = e.second;
-
-            if (name2vertex[s1] > name2vertex[s2]) {
-                std::swap(s1, s2);
-            }
-
-            VertexNumber v1 = name2vertex[s1];
-            VertexNumber v2 = name2vertex[s2];
+        if (uniqueIds.size() > size_t(MAX_EDGES)) throw std::runtime_error(
+                "ERROR: Edge number > " + to_string(MAX_EDGES));
+        edgeInfo_.reserve(uniqueIds.size());
+        edgeReversed_.reserve(uniqueIds.size());
 
-            if (v1 == 0) throw std::runtime_error(
-                    "ERROR: " + s1 + ": No such vertex");
-            if (v2 == 0) throw std::runtime_error(
-                    "ERROR: " + s2 + ": No such vertex");
+        for (size_t i = 0; i < uniqueIds.size(); ++i) {
+            VertexNumber v1 = number[uniqueIds[i].first];
+            VertexNumber v2 = number[uniqueIds[i].second];
+            bool reversed = v1 > v2;
 
-            VertexNumberPair vp(v1, v2);
-
-            if (edgeIndex.count(vp) == 0) {
-                EdgeNumber a = edgeInfo_.size();
-                edgeInfo_.push_back(EdgeInfo(v1, v2));
-                edgeIndex[vp] = a;
-                name2edge[std::make_pair(s1, s2)] = a;
-                name2edge[std::make_pair(s2, s1)] = a;
-                if (vMax < v2) vMax = v2;
+            if (reversed) {
+                std::swap(v1, v2);
             }
 
-            if (edgeInfo_.size() > size_t(MAX_EDGES)) throw std::runtime_error(
-                    "ERROR: Edge number > " + to_string(MAX_EDGES));
+            edgeInfo_.push_back(EdgeInfo(v1, v2));
+            edgeReversed_.push_back(reversed);
+            if (vMax < v2) vMax = v2;
         }
 
         {
@@ -370,9 +861,11 @@ public:
 
             for (std::map<std::string,std::string>::iterator t =
                     name2color.begin(); t != name2color.end(); ++t) {
-                VertexNumber v = name2vertex[t->first];
-                if (v == 0) throw std::runtime_error(
+                std::map<std::string,VertexNumber>::const_iterator found =
+                        name2vertex.find(t->first);
+                if (found == name2vertex.end()) throw std::runtime_error(
                         "ERROR: " + t->first + ": No such vertex");
+                VertexNumber v = found->second;
                 color2vertices[t->second].insert(v); // color => set of vertices
             }
 
@@ -483,12 +976,26 @@ public:
                 e.finalEdge = (a == edgeSize() - 1);
             }
         }
+
+        updateAdjacency();
     }
 
     VertexNumber vertexSize() const {
         return vMax;
     }
 
+    /**
+     * Returns the neighbors of vertex u without copying them.
+     * A self-loop makes u its own neighbor once.
+     */
+    NeighborSpan neighbors(VertexNumber u) const {
+        assert(1 <= u && u <= vMax);
+        int const b = adjOffset_[u];
+        int const e = adjOffset_[u + 1];
+        return NeighborSpan(adjVertex_.data() + b, adjVertex_.data() + e,
+                            adjEdge_.data() + b);
+    }
+
     EdgeNumber edgeSize() const {
         return edgeInfo_.size();
     }
@@ -501,7 +1008,7 @@ public:
 
     VertexNumber getVertex(std::string const& name) const {
         std::map<std::string,VertexNumber>::const_iterator found =
-                name2vertex.find(name);
+                nameIndex().find(name);
         if (found == name2vertex.end()) throw std::runtime_error(
                 "ERROR: " + name + ": No such vertex");
         return found->second;
@@ -525,11 +1032,17 @@ public:
     }
 
     EdgeNumber getEdge(std::pair<std::string,std::string> const& name) const {
-        std::map<std::pair<std::string,std::string>,EdgeNumber>::const_iterator found =
-                name2edge.find(name);
-        if (found == name2edge.end()) throw std::runtime_error(
+        std::map<std::string,VertexNumber>::const_iterator v1 =
+                nameIndex().find(name.first);
+        std::map<std::string,VertexNumber>::const_iterator v2 =
+                name2vertex.find(name.second);
+        EdgeNumber a = -1;
+        if (v1 != name2vertex.end() && v2 != name2vertex.end()) {
+            a = findEdge(v1->second, v2->second);
+        }
+        if (a < 0) throw std::runtime_error(
                 "ERROR: " + name.first + "," + name.second + ": No such edge");
-        return found->second;
+        return a;
     }
 
     EdgeNumber getEdge(std::string const& name1,
@@ -539,7 +1052,11 @@ public:
 
     std::pair<std::string,std::string> edgeName(EdgeNumber e) const {
         if (e < 0 || edgeSize() <= e) return std::make_pair("?", "?");
-        return edge2name[e];
+        EdgeInfo const& a = edgeInfo_[e];
+        if (edgeReversed_[e]) {
+            return std::make_pair(vertex2name[a.v2], vertex2name[a.v1]);
+        }
+        return std::make_pair(vertex2name[a.v1], vertex2name[a.v2]);
     }
 
     std::string edgeLabel(EdgeNumber e) const {
@@ -562,16 +1079,31 @@ public:
     EdgeNumber getEdge(VertexNumber v1, VertexNumber v2) const {
         assert(1 <= v1 && v1 <= vMax);
         assert(1 <= v2 && v2 <= vMax);
-        if (v1 > v2) std::swap(v1, v2);
-        VertexNumberPair vp(v1, v2);
-        std::map<VertexNumberPair,EdgeNumber>::const_iterator found =
-                edgeIndex.find(vp);
-        if (found == edgeIndex.end()) throw std::runtime_error(
-                "ERROR: (" + to_string(v1) + "," + to_string(v2)
-                        + "): No such edge");
-        return found->second;
+        EdgeNumber a = findEdge(v1, v2);
+        if (a < 0) throw std::runtime_error(
+                "ERROR: (" + to_string(std::min(v1, v2)) + ","
+                        + to_string(std::max(v1, v2)) + "): No such edge");
+        return a;
     }
 
+private:
+    // Looks up the edge between v1 and v2 in the adjacency of the end of
+    // lower degree; returns -1 if there is none.
+    EdgeNumber findEdge(VertexNumber v1, VertexNumber v2) const {
+        NeighborSpan n1 = neighbors(v1);
+        NeighborSpan n2 = neighbors(v2);
+        if (n2.size() < n1.size()) {
+            std::swap(n1, n2);
+            std::swap(v1, v2);
+        }
+        for (size_t i = 0; i < n1.size(); ++i) {
+            if (n1[i] == v2) return n1.edge(i);
+        }
+        return -1;
+    }
+
+public:
+
     VertexNumber maxFrontierSize() const {
         VertexNumber n = 0;
         for (EdgeNumber a = 0; a < edgeSize(); ++a) {
@@ -840,475 +1372,256 @@ private:
 //
         // 获取顶点的所有邻居
         std::vector<VertexNumber> getNeighbors(VertexNumber u) const {
-            std::vector<VertexNumber> neighbors;
-
-            for (EdgeNumber e = 0; e < edgeSize(); ++e) {
-                const EdgeInfo& edge = edgeInfo(e);
-                if (edge.v1 == u) {
-                    neighbors.push_back(edge.v2);
-                } else if (edge.v2 == u) {
-                    neighbors.push_back(edge.v1);
-                }
-            }
-
-            return neighbors;
+            NeighborSpan span = neighbors(u);
+            return std::vector<VertexNumber>(span.begin(), span.end());
         }
     // 改进的BCC分解算法
     std::vector<Graph> improvedBCCDecompose() const {
-        std::vector<Graph> result;
-
-        // 使用并查集来跟踪连通分量
-        std::vector<int> parent(vMax + 1);
-        std::vector<int> rank(vMax + 1, 0);
-
-        // 初始化并查集
-        for (VertexNumber v = 1; v <= vMax; ++v) {
-            parent[v] = v;
-        }
-
-        std::function<int(int)> find = [&](int x) -> int {
-            if (parent[x] != x) {
-                parent[x] = find(parent[x]);
-            }
-            return parent[x];
-        };
-
-        auto unite = [&](int x, int y) {
-            int px = find(x), py = find(y);
-            if (px == py) return;
-            if (rank[px] < rank[py]) std::swap(px, py);
-            parent[py] = px;
-            if (rank[px] == rank[py]) rank[px]++;
-        };
-
-        // 首先找到所有桥边
-        std::set<std::pair<VertexNumber, VertexNumber>> bridges;
-        std::vector<int> disc(vMax + 1, -1);
-        std::vector<int> low(vMax + 1, -1);
-        std::vector<bool> visited(vMax + 1, false);
-        int timer = 0;
-
-        std::function<void(VertexNumber, VertexNumber)> bridgeDFS =
-                [&](VertexNumber u, VertexNumber p) {
-                    visited[u] = true;
-                    disc[u] = low[u] = ++timer;
-
-                    std::vector<VertexNumber> neighbors = getNeighbors(u);
-                    for (VertexNumber v : neighbors) {
-                        if (v == p) continue; // 跳过父节点
-
-                        if (!visited[v]) {
-                            bridgeDFS(v, u);
-                            low[u] = std::min(low[u], low[v]);
-
-                            if (low[v] > disc[u]) {
-                                bridges.insert({std::min(u, v), std::max(u, v)});
-                            }
-                        } else {
-                            low[u] = std::min(low[u], disc[v]);
-                        }
-                    }
-                };
-
-        // 找到所有桥边
-        for (VertexNumber v = 1; v <= vMax; ++v) {
-            if (!visited[v]) {
-                bridgeDFS(v, -1);
-            }
-        }
-
-        // 合并非桥边连接的顶点
-        for (EdgeNumber e = 0; e < edgeSize(); ++e) {
-            const EdgeInfo& edge = edgeInfo(e);
-            VertexNumber v1 = edge.v1;
-            VertexNumber v2 = edge.v2;
-
-            std::pair<VertexNumber, VertexNumber> edgePair = {std::min(v1, v2), std::max(v1, v2)};
-            if (bridges.find(edgePair) == bridges.end()) {
-                unite(v1, v2);
-            }
-        }
-
-        // 收集BCC
-        std::map<int, std::vector<VertexNumber>> bccMap;
-        for (VertexNumber v = 1; v <= vMax; ++v) {
-            bccMap[find(v)].push_back(v);
-        }
-
-        // 创建BCC图
-        for (const auto& bccPair : bccMap) {
-            if (bccPair.second.size() < 2) continue; // 跳过单个顶点
-
-            Graph bccGraph;
-            const std::vector<VertexNumber>& bccVertices = bccPair.second;
-
-            // 添加BCC内的边
-            for (EdgeNumber e = 0; e < edgeSize(); ++e) {
-                const EdgeInfo& edge = edgeInfo(e);
-                VertexNumber v1 = edge.v1;
-                VertexNumber v2 = edge.v2;
-
-                bool v1InBcc = std::find(bccVertices.begin(), bccVertices.end(), v1) != bccVertices.end();
-                bool v2InBcc = std::find(bccVertices.begin(), bccVertices.end(), v2) != bccVertices.end();
-
-                if (v1InBcc && v2InBcc) {
-                    std::pair<VertexNumber, VertexNumber> edgePair = {std::min(v1, v2), std::max(v1, v2)};
-                    if (bridges.find(edgePair) == bridges.end()) {
-                        bccGraph.addEdge(vertex2name[v1], vertex2name[v2]);
-                    }
-                }
-            }
-
-            // 复制颜色信息
-            for (VertexNumber v : bccVertices) {
-                std::string vertexName = vertex2name[v];
-                auto colorIt = name2color.find(vertexName);
-                if (colorIt != name2color.end()) {
-                    bccGraph.setColor(vertexName, colorIt->second);
-                }
-            }
-
-            if (!bccGraph.edgeNames.empty()) {
-                bccGraph.update();
-                result.push_back(bccGraph);
-            }
-        }
-
-        // 创建桥边树
-        if (!bridges.empty()) {
-            Graph bridgeTree;
-            for (const auto& bridge : bridges) {
-                bridgeTree.addEdge(vertex2name[bridge.first], vertex2name[bridge.second]);
-            }
-            bridgeTree.update();
-            result.push_back(bridgeTree);
-        }
+        BlockDecomposition blocks = decomposeBlocks();
 
+        // 按DFS记录的块号一次扫描生成各个块的子图
+        std::vector<Graph> result = blockGraphs(blocks);
 
+        // 创建桥边森林
+        Graph bridges = bridgeGraph(blocks);
+        if (bridges.edgeSize() > 0) result.push_back(std::move(bridges));
         return result;
     }
         // 改进的BCC分解算法
         std::vector<Graph> improvedBCCDecompose1() const {
-            std::vector<Graph> result;
-
-            // 使用并查集来跟踪连通分量
-            std::vector<int> parent(vMax + 1);
-            std::vector<int> rank(vMax + 1, 0);
-
-            // 初始化并查集
-            for (VertexNumber v = 1; v <= vMax; ++v) {
-                parent[v] = v;
-            }
-
-            std::function<int(int)> find = [&](int x) -> int {
-                if (parent[x] != x) {
-                    parent[x] = find(parent[x]);
-                }
-                return parent[x];
-            };
-
-            auto unite = [&](int x, int y) {
-                int px = find(x), py = find(y);
-                if (px == py) return;
-                if (rank[px] < rank[py]) std::swap(px, py);
-                parent[py] = px;
-                if (rank[px] == rank[py]) rank[px]++;
-            };
-
-            // 首先找到所有桥边
-            std::set<std::pair<VertexNumber, VertexNumber>> bridges;
-            std::vector<int> disc(vMax + 1, -1);
-            std::vector<int> low(vMax + 1, -1);
-            std::vector<bool> visited(vMax + 1, false);
-            int timer = 0;
-
-            std::function<void(VertexNumber, VertexNumber)> bridgeDFS =
-                    [&](VertexNumber u, VertexNumber p) {
-                        visited[u] = true;
-                        disc[u] = low[u] = ++timer;
-
-                        std::vector<VertexNumber> neighbors = getNeighbors(u);
-                        for (VertexNumber v : neighbors) {
-                            if (v == p) continue; // 跳过父节点
-
-                            if (!visited[v]) {
-                                bridgeDFS(v, u);
-                                low[u] = std::min(low[u], low[v]);
-
-                                if (low[v] > disc[u]) {
-                                    bridges.insert({std::min(u, v), std::max(u, v)});
-                                }
-                            } else {
-                                low[u] = std::min(low[u], disc[v]);
-                            }
-                        }
-                    };
-
-            // 找到所有桥边
-            for (VertexNumber v = 1; v <= vMax; ++v) {
-                if (!visited[v]) {
-                    bridgeDFS(v, -1);
-                }
-            }
-
-            // 合并非桥边连接的顶点
-            for (EdgeNumber e = 0; e < edgeSize(); ++e) {
-                const EdgeInfo& edge = edgeInfo(e);
-                VertexNumber v1 = edge.v1;
-                VertexNumber v2 = edge.v2;
-
-                std::pair<VertexNumber, VertexNumber> edgePair = {std::min(v1, v2), std::max(v1, v2)};
-                if (bridges.find(edgePair) == bridges.end()) {
-                    unite(v1, v2);
-                }
-            }
-
-            // 收集BCC
-            std::map<int, std::vector<VertexNumber>> bccMap;
-            for (VertexNumber v = 1; v <= vMax; ++v) {
-                bccMap[find(v)].push_back(v);
-            }
-
-            // 创建BCC图
-            for (const auto& bccPair : bccMap) {
-                if (bccPair.second.size() < 2) continue; // 跳过单个顶点
-
-                Graph bccGraph;
-                const std::vector<VertexNumber>& bccVertices = bccPair.second;
-
-                // 添加BCC内的边
-                for (EdgeNumber e = 0; e < edgeSize(); ++e) {
-                    const EdgeInfo& edge = edgeInfo(e);
-                    VertexNumber v1 = edge.v1;
-                    VertexNumber v2 = edge.v2;
-
-                    bool v1InBcc = std::find(bccVertices.begin(), bccVertices.end(), v1) != bccVertices.end();
-                    bool v2InBcc = std::find(bccVertices.begin(), bccVertices.end(), v2) != bccVertices.end();
-
-                    if (v1InBcc && v2InBcc) {
-                        std::pair<VertexNumber, VertexNumber> edgePair = {std::min(v1, v2), std::max(v1, v2)};
-                        if (bridges.find(edgePair) == bridges.end()) {
-                            bccGraph.addEdge(vertex2name[v1], vertex2name[v2]);
-                        }
-                    }
-                }
-
-                // 复制颜色信息
-                for (VertexNumber v : bccVertices) {
-                    std::string vertexName = vertex2name[v];
-                    auto colorIt = name2color.find(vertexName);
-                    if (colorIt != name2color.end()) {
-                        bccGraph.setColor(vertexName, colorIt->second);
-                    }
-                }
-
-                if (!bccGraph.edgeNames.empty()) {
-                    bccGraph.update();
-                    result.push_back(bccGraph);
-                }
-            }
-
-// 创建桥边森林子图
-            if (!bridges.empty()) {
-                int upper_bound = 5;
-                // 构造邻接表
-                std::map<VertexNumber, std::vector<VertexNumber>> adj;
-                for (const auto& bridge : bridges) {
-                    adj[bridge.first].push_back(bridge.second);
-                    adj[bridge.second].push_back(bridge.first);
-                }
-
-                std::set<VertexNumber> visited;
-
-                std::function<void(VertexNumber, std::set<std::pair<VertexNumber, VertexNumber>>&,
-                                   std::set<VertexNumber>&, int&, int)> dfsCollect;
-                dfsCollect = [&](VertexNumber u,
-                                 std::set<std::pair<VertexNumber, VertexNumber>>& edges,
-                                 std::set<VertexNumber>& vertices,
-                                 int& edgeCount,
-                                 int edgeLimit) {
-                    visited.insert(u);
-                    vertices.insert(u);
-                    for (VertexNumber v : adj[u]) {
-                        std::pair<VertexNumber, VertexNumber> e = {std::min(u, v), std::max(u, v)};
-                        if (edges.count(e)) continue;
-                        if (edgeCount >= edgeLimit) continue;
-
-                        edges.insert(e);
-                        edgeCount++;
-
-                        if (!visited.count(v)) {
-                            dfsCollect(v, edges, vertices, edgeCount, edgeLimit);
-                        }
-                    }
-                };
-
-                for (VertexNumber v = 1; v <= vMax; ++v) {
-                    if (adj.count(v) && !visited.count(v)) {
-                        std::set<std::pair<VertexNumber, VertexNumber>> collectedEdges;
-                        std::set<VertexNumber> collectedVertices;
-                        int edgeCount = 0;
-                        dfsCollect(v, collectedEdges, collectedVertices, edgeCount, upper_bound);
-
-                        // 构建一个子图
-                        Graph subtree;
-                        for (const auto& edge : collectedEdges) {
-                            subtree.addEdge(vertex2name[edge.first], vertex2name[edge.second]);
-                        }
-
-                        for (VertexNumber u : collectedVertices) {
-                            std::string name = vertex2name[u];
-                            auto it = name2color.find(name);
-                            if (it != name2color.end()) {
-                                subtree.setColor(name, it->second);
-                            }
-                        }
-
-                        if (!subtree.edgeNames.empty()) {
-                            subtree.update();
-                            result.push_back(subtree);
-                        }
-                    }
-                }
-            }
+            BlockDecomposition blocks = decomposeBlocks();
 
+            // 按DFS记录的块号一次扫描生成各个块的子图
+            std::vector<Graph> result = blockGraphs(blocks);
 
+            // 创建桥边森林子图，每条桥边恰好属于其中一棵树
+            Graph bridges = bridgeGraph(blocks);
+            if (bridges.edgeSize() > 0) result.push_back(std::move(bridges));
             return result;
         }
     std::vector<Graph> improvedBCCDecompose_(Graph& bridgeForest, int& cnt) const {
-        std::vector<Graph> result;
+        BlockDecomposition blocks = decomposeBlocks();
 
-        // 使用并查集来跟踪连通分量
-        std::vector<int> parent(vMax + 1);
-        std::vector<int> rank(vMax + 1, 0);
+        // 按DFS记录的块号一次扫描生成各个块的子图
+        std::vector<Graph> result = blockGraphs(blocks);
 
-        // 初始化并查集
-        for (VertexNumber v = 1; v <= vMax; ++v) {
-            parent[v] = v;
+        // 创建桥边树
+        Graph bridges = bridgeGraph(blocks);
+        if (bridges.edgeSize() > 0) {
+            cnt += bridges.edgeSize();
+            bridgeForest = std::move(bridges);
+        }
+        return result;
+    }
+    public:
+    /**
+     * Returns this graph with its edges in the given order: edge i of the
+     * result is edge order[i] of this graph. Vertex names, labels and
+     * colors are kept; vertex numbers follow the new order.
+     */
+    Graph reordered(std::vector<EdgeNumber> const& order) const {
+        assert(order.size() == size_t(edgeSize()));
+        Graph g;
+        g.name2label = name2label;
+        g.name2color = name2color;
+        g.indexedName_.assign(vertex2name.begin() + 1, vertex2name.end());
+        g.indexedEdges_.reserve(order.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            EdgeInfo const& e = edgeInfo_[order[i]];
+            int const a = e.v1 - 1;
+            int const b = e.v2 - 1;
+            g.indexedEdges_.push_back(edgeReversed_[order[i]]
+                    ? std::make_pair(b, a) : std::make_pair(a, b));
         }
+        g.update();
+        return g;
+    }
 
-        std::function<int(int)> find = [&](int x) -> int {
-            if (parent[x] != x) {
-                parent[x] = find(parent[x]);
+    /**
+     * Makes one graph per block of blocks, skipping bridges, in a single
+     * sweep over the edges grouped by block. The vertices of each block get
+     * dense local indices as they are met, so every name is copied once
+     * per block that contains it. Vertex names and colors are kept.
+     */
+    std::vector<Graph> blockGraphs(BlockDecomposition const& blocks) const {
+        // edges of block b are byBlock[head[b] .. head[b+1]), in edge order
+        std::vector<size_t> head(blocks.numBlocks + 1, 0);
+        for (EdgeNumber a = 0; a < edgeSize(); ++a) {
+            if (blocks.isBridge[a]) continue;
+            ++head[blocks.blockOf[a] + 1];
+        }
+        for (int b = 0; b < blocks.numBlocks; ++b) {
+            head[b + 1] += head[b];
+        }
+        std::vector<EdgeNumber> byBlock(head[blocks.numBlocks]);
+        {
+            std::vector<size_t> pos(head.begin(), head.end() - 1);
+            for (EdgeNumber a = 0; a < edgeSize(); ++a) {
+                if (blocks.isBridge[a]) continue;
+                byBlock[pos[blocks.blockOf[a]]++] = a;
             }
-            return parent[x];
-        };
-
-        auto unite = [&](int x, int y) {
-            int px = find(x), py = find(y);
-            if (px == py) return;
-            if (rank[px] < rank[py]) std::swap(px, py);
-            parent[py] = px;
-            if (rank[px] == rank[py]) rank[px]++;
-        };
-
-        // 首先找到所有桥边
-        std::set<std::pair<VertexNumber, VertexNumber>> bridges;
-        std::vector<int> disc(vMax + 1, -1);
-        std::vector<int> low(vMax + 1, -1);
-        std::vector<bool> visited(vMax + 1, false);
-        int timer = 0;
-
-        std::function<void(VertexNumber, VertexNumber)> bridgeDFS =
-                [&](VertexNumber u, VertexNumber p) {
-                    visited[u] = true;
-                    disc[u] = low[u] = ++timer;
-
-                    std::vector<VertexNumber> neighbors = getNeighbors(u);
-                    for (VertexNumber v : neighbors) {
-                        if (v == p) continue; // 跳过父节点
-
-                        if (!visited[v]) {
-                            bridgeDFS(v, u);
-                            low[u] = std::min(low[u], low[v]);
-
-                            if (low[v] > disc[u]) {
-                                bridges.insert({std::min(u, v), std::max(u, v)});
-                            }
-                        } else {
-                            low[u] = std::min(low[u], disc[v]);
-                        }
-                    }
-                };
+        }
 
-        // 找到所有桥边
-        for (VertexNumber v = 1; v <= vMax; ++v) {
-            if (!visited[v]) {
-                bridgeDFS(v, -1);
+        std::vector<Graph> result;
+        // local[v]: index of v in block seen[v]
+        std::vector<int> seen(vMax + 1, -1);
+        std::vector<int> local(vMax + 1);
+        for (int b = 0; b < blocks.numBlocks; ++b) {
+            if (head[b] == head[b + 1]) continue;
+            Graph g;
+            std::vector<std::string> names;
+            std::vector<std::pair<int,int> > edges;
+            edges.reserve(head[b + 1] - head[b]);
+            for (size_t k = head[b]; k < head[b + 1]; ++k) {
+                EdgeInfo const& e = edgeInfo_[byBlock[k]];
+                VertexNumber const ends[2] = {e.v1, e.v2};
+                for (int j = 0; j < 2; ++j) {
+                    VertexNumber const v = ends[j];
+                    if (seen[v] == b) continue;
+                    seen[v] = b;
+                    local[v] = names.size();
+                    names.push_back(vertex2name[v]);
+                    if (name2color.empty()) continue;
+                    std::map<std::string,std::string>::const_iterator c =
+                            name2color.find(names.back());
+                    if (c != name2color.end()) g.name2color.insert(*c);
+                }
+                edges.push_back(std::make_pair(local[e.v1], local[e.v2]));
             }
+            g.setIndexedEdges(std::move(names), std::move(edges));
+            result.push_back(std::move(g));
         }
+        return result;
+    }
 
-        // 合并非桥边连接的顶点
-        for (EdgeNumber e = 0; e < edgeSize(); ++e) {
-            const EdgeInfo& edge = edgeInfo(e);
-            VertexNumber v1 = edge.v1;
-            VertexNumber v2 = edge.v2;
-
-            std::pair<VertexNumber, VertexNumber> edgePair = {std::min(v1, v2), std::max(v1, v2)};
-            if (bridges.find(edgePair) == bridges.end()) {
-                unite(v1, v2);
+    /**
+     * Makes the forest of the bridges of blocks in a single sweep over the
+     * edges, with the vertices numbered densely as they are met. Vertex
+     * names and colors are kept. The forest has no edges if there are no
+     * bridges.
+     */
+    Graph bridgeGraph(BlockDecomposition const& blocks) const {
+        Graph g;
+        std::vector<std::string> names;
+        std::vector<std::pair<int,int> > edges;
+        // local[v]: index of v in the forest, or -1
+        std::vector<int> local(vMax + 1, -1);
+        for (EdgeNumber a = 0; a < edgeSize(); ++a) {
+            if (!blocks.isBridge[a]) continue;
+            EdgeInfo const& e = edgeInfo_[a];
+            VertexNumber const ends[2] = {e.v1, e.v2};
+            for (int j = 0; j < 2; ++j) {
+                VertexNumber const v = ends[j];
+                if (local[v] >= 0) continue;
+                local[v] = names.size();
+                names.push_back(vertex2name[v]);
+                if (name2color.empty()) continue;
+                std::map<std::string,std::string>::const_iterator c =
+                        name2color.find(names.back());
+                if (c != name2color.end()) g.name2color.insert(*c);
             }
+            edges.push_back(std::make_pair(local[e.v1], local[e.v2]));
         }
-
-        // 收集BCC
-        std::map<int, std::vector<VertexNumber>> bccMap;
-        for (VertexNumber v = 1; v <= vMax; ++v) {
-            bccMap[find(v)].push_back(v);
+        if (!edges.empty()) {
+            g.setIndexedEdges(std::move(names), std::move(edges));
         }
+        return g;
+    }
 
-        // 创建BCC图
-        for (const auto& bccPair : bccMap) {
-            if (bccPair.second.size() < 2) continue; // 跳过单个顶点
+    /**
+     * Finds the blocks, bridges and articulation points in one O(n+m)
+     * depth-first search (Hopcroft and Tarjan). The search keeps its own
+     * stack, so long paths do not overflow the call stack. A decomposition
+     * given by setBlockDecomposition() is returned as is.
+     */
+    BlockDecomposition decomposeBlocks() const {
+        if (hasKnownBlocks_) return knownBlocks_;
 
-            Graph bccGraph;
-            const std::vector<VertexNumber>& bccVertices = bccPair.second;
+        BlockDecomposition d;
+        d.blockOf.assign(edgeSize(), -1);
+        d.isBridge.assign(edgeSize(), false);
+        d.isArticulation.assign(vMax + 1, false);
+        d.numBlocks = 0;
 
-            // 添加BCC内的边
-            for (EdgeNumber e = 0; e < edgeSize(); ++e) {
-                const EdgeInfo& edge = edgeInfo(e);
-                VertexNumber v1 = edge.v1;
-                VertexNumber v2 = edge.v2;
+        struct Frame {
+            VertexNumber v;
+            // edge from the parent, or -1 at a root
+            EdgeNumber parentEdge;
+            // index of the next neighbor to visit
+            size_t next;
+            int children;
+        };
+
+        // discovery time (0 for unvisited vertices) and low point
+        std::vector<int> disc(vMax + 1, 0);
+        std::vector<int> low(vMax + 1, 0);
+        std::vector<Frame> stack;
+        // edges of the blocks not completed yet
+        std::vector<EdgeNumber> edgeStack;
+        int timer = 0;
 
-                bool v1InBcc = std::find(bccVertices.begin(), bccVertices.end(), v1) != bccVertices.end();
-                bool v2InBcc = std::find(bccVertices.begin(), bccVertices.end(), v2) != bccVertices.end();
+        for (VertexNumber root = 1; root <= vMax; ++root) {
+            if (disc[root] != 0) continue;
+            disc[root] = low[root] = ++timer;
+            Frame top = {root, -1, 0, 0};
+            stack.push_back(top);
 
-                if (v1InBcc && v2InBcc) {
-                    std::pair<VertexNumber, VertexNumber> edgePair = {std::min(v1, v2), std::max(v1, v2)};
-                    if (bridges.find(edgePair) == bridges.end()) {
-                        bccGraph.addEdge(vertex2name[v1], vertex2name[v2]);
+            while (!stack.empty()) {
+                Frame& f = stack.back();
+                NeighborSpan nb = neighbors(f.v);
+                if (f.next < nb.size()) {
+                    VertexNumber const w = nb[f.next];
+                    EdgeNumber const a = nb.edge(f.next);
+                    ++f.next;
+                    if (a == f.parentEdge) continue;
+                    if (disc[w] == 0) { // tree edge
+                        edgeStack.push_back(a);
+                        ++f.children;
+                        disc[w] = low[w] = ++timer;
+                        Frame child = {w, a, 0, 0};
+                        stack.push_back(child);
+                    }
+                    else if (disc[w] < disc[f.v]) { // back edge
+                        edgeStack.push_back(a);
+                        low[f.v] = std::min(low[f.v], disc[w]);
                     }
+                    continue;
                 }
-            }
 
-            // 复制颜色信息
-            for (VertexNumber v : bccVertices) {
-                std::string vertexName = vertex2name[v];
-                auto colorIt = name2color.find(vertexName);
-                if (colorIt != name2color.end()) {
-                    bccGraph.setColor(vertexName, colorIt->second);
+                // f.v is finished
+                VertexNumber const v = f.v;
+                EdgeNumber const a = f.parentEdge;
+                int const children = f.children;
+                stack.pop_back();
+                if (stack.empty()) {
+                    if (children > 1) d.isArticulation[v] = true;
+                    break;
                 }
-            }
 
-            if (!bccGraph.edgeNames.empty()) {
-                bccGraph.update();
-                result.push_back(bccGraph);
+                Frame const& p = stack.back();
+                low[p.v] = std::min(low[p.v], low[v]);
+                if (low[v] >= disc[p.v]) {
+                    // p.v separates the subtree of v: its block is complete
+                    if (p.parentEdge >= 0) d.isArticulation[p.v] = true;
+                    if (low[v] > disc[p.v]) d.isBridge[a] = true;
+                    EdgeNumber b;
+                    do {
+                        b = edgeStack.back();
+                        edgeStack.pop_back();
+                        d.blockOf[b] = d.numBlocks;
+                    } while (b != a);
+                    ++d.numBlocks;
+                }
             }
         }
 
-        // 创建桥边树
-        if (!bridges.empty()) {
-            Graph bridgeTree;
-            for (const auto& bridge : bridges) {
-                bridgeTree.addEdge(vertex2name[bridge.first], vertex2name[bridge.second]);
-                cnt++;
-            }
-            bridgeTree.update();
-            bridgeForest = bridgeTree;
+        // self-loops are never pushed on the edge stack
+        for (EdgeNumber a = 0; a < edgeSize(); ++a) {
+            if (d.blockOf[a] < 0) d.blockOf[a] = d.numBlocks++;
         }
-
-        return result;
+        return d;
     }
-    public:
+
         // 主要的分解接口，使用改进的算法
         std::vector<Graph> decomposeToBCCAndBridges() const {
             return improvedBCCDecompose();